@@ -0,0 +1,232 @@
+// Adaptive.hpp
+// Rylee Alanza Lyman (ryleealanza@gmail.com)
+//
+// anti-aliased waveshaping that spends the fourth order only where the input needs it.
+// aliasing comes from the harmonics the shaper adds above Nyquist, so a bass line or a quiet passage
+// gains little from d4 over a lower order, or from either over the plain waveshape;
+// this picks the order block by block from how hard and how fast the input moves.
+
+#pragma once
+
+#include "Kernels.hpp"
+#include "Target.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace DADAA {
+inline namespace DADAA_TARGET {
+
+// anti-aliased waveshaping with Shaper at order 0, 2 or 4, chosen per chunk of 64 samples.
+// the even orders delay the wet signal by whole samples, so each is delayed to the fourth order's 2,
+// and a change of order crossfades between the two, aligned, over part of a chunk: quickly going up,
+// so that little of a transient goes through the lower order, and over the whole chunk coming down.
+// the order goes up as soon as a chunk asks for it, and down only after kHold chunks in a row have.
+// the dry signal is the input delayed by the same 2 samples; with a null dry, only the wet signal is written.
+// the differences are computed in double, as Distortion's are by default.
+template <class Shaper>
+class AdaptiveDistortion {
+public:
+  explicit AdaptiveDistortion(float gain = 0.f, const Shaper& shaper = Shaper()) :
+    mGain(gain), mSecond(shaper), mFourth(shaper) {}
+
+  // gain at control or scalar rate, ramped as Distortion ramps it
+  void process(const float* input, float gain, float* wet, float* dry, int nSamples) {
+    if (gain == mGain) {
+      const double constant = gain;
+      run(input, [constant](int) { return constant; }, wet, dry, nSamples);
+    } else {
+      const double start = mGain;
+      const double slope = (static_cast<double>(gain) - start) / nSamples;
+      mGain = gain;
+      run(input, [start, slope](int i) { return start + slope * i; }, wet, dry, nSamples);
+    }
+  }
+
+  // gain at audio rate, one value per sample
+  void process(const float* input, const float* gain, float* wet, float* dry, int nSamples) {
+    run(input, [gain](int i) { return static_cast<double>(gain[i]); }, wet, dry, nSamples);
+  }
+
+  // the order the last chunk ended at
+  int order() const { return mOrder; }
+
+  // the delay of the wet signal, in samples: the fourth order's, whichever order is running
+  static constexpr double latency() { return 2.; }
+
+  // the order a chunk of gain-scaled inputs asks for, given the input before it.
+  // the shapers bend between about -1 and 1 and are flat or nearly linear elsewhere,
+  // so their harmonics reach as high as the input is quick to cross that knee, or, short of it, as the input itself:
+  // the largest move from one input to the next over the smaller of the peak and 1
+  // is roughly the highest frequency that matters, in radians per sample.
+  // near zero the shapers are close to linear, and below a few hundred Hz their harmonics
+  // have fallen off well before Nyquist, so either calls for no anti-aliasing at all;
+  // below a couple of kHz, or short of the knee, the second order is enough.
+  static int orderFor(const double* in, int n, double last) {
+    double peak = std::abs(in[0]);
+    double step = std::abs(in[0] - last);
+    for (int i = 1; i < n; ++i) {
+      peak = std::max(peak, std::abs(in[i]));
+      step = std::max(step, std::abs(in[i] - in[i - 1]));
+    }
+    const double knee = std::min(peak, 1.);
+    if (peak < kLinearPeak || step < kLowBand * knee) {
+      return 0;
+    }
+    if (peak < kGentlePeak || step < kMidBand * knee) {
+      return 2;
+    }
+    return 4;
+  }
+
+private:
+  static constexpr int kChunk = 64;
+  static constexpr int kHold = 8;
+  static constexpr int kFadeUp = 16;
+  // the thresholds of orderFor: gain-scaled levels, and frequencies in radians per sample,
+  // about 300 Hz and 2 kHz at 48 kHz
+  static constexpr double kLinearPeak = 0.1;
+  static constexpr double kGentlePeak = 0.5;
+  static constexpr double kLowBand = 0.04;
+  static constexpr double kMidBand = 0.26;
+
+  template <class Gain>
+  void run(const float* input, Gain gainAt, float* wet, float* dry, int nSamples) {
+    // work from copies of the input, since the server may hand us an output buffer aliasing it
+    for (int offset = 0; offset < nSamples; offset += kChunk) {
+      const int count = nSamples - offset < kChunk ? nSamples - offset : kChunk;
+      float raw[kChunk];
+      double scaled[kChunk];
+      for (int i = 0; i < count; ++i) {
+        raw[i] = input[offset + i];
+        scaled[i] = flushDenormal(static_cast<double>(raw[i]) * gainAt(offset + i));
+      }
+
+      const bool still = settled(scaled, count);
+      int wanted = still ? 0 : orderFor(scaled, count, mHistory[0]);
+      if (wanted >= mOrder) {
+        mCalm = 0;
+      } else if (++mCalm < kHold) {
+        wanted = mOrder;
+      } else {
+        mCalm = 0;
+      }
+
+      if (still) {
+        // every order holds the waveshape of a constant input, so a change of order needs no crossfade
+        countBranch(kSettled, count);
+        const double held = mFourth.shaper().waveshape0(scaled[0]);
+        for (int i = 0; i < count; ++i) {
+          wet[offset + i] = static_cast<float>(held);
+        }
+        if (wanted != mOrder) {
+          start(wanted);
+          mOrder = wanted;
+        }
+        mLastSecond = held;
+      } else if (wanted == mOrder) {
+        countBranch(kSamples, count);
+        shape(mOrder, scaled, wet + offset, count);
+      } else {
+        // both orders run over the chunk, the new one from a table primed on the history
+        countBranch(kSamples, 2 * count);
+        start(wanted);
+        float from[kChunk];
+        float to[kChunk];
+        shape(mOrder, scaled, from, count);
+        shape(wanted, scaled, to, count);
+        const int fade = wanted > mOrder ? std::min(kFadeUp, count) : count;
+        for (int i = 0; i < count; ++i) {
+          const float t = i < fade ? static_cast<float>(i + 1) / fade : 1.f;
+          wet[offset + i] = from[i] + t * (to[i] - from[i]);
+        }
+        mOrder = wanted;
+      }
+
+      for (int i = count < 4 ? 0 : count - 4; i < count; ++i) {
+        mHistory.push(scaled[i]);
+      }
+      if (dry == nullptr) {
+        continue;
+      }
+      for (int i = 0; i < count; ++i) {
+        dry[offset + i] = i < 2 ? mInput[1 - i] : raw[i - 2];
+      }
+      for (int i = count < 4 ? 0 : count - 4; i < count; ++i) {
+        mInput.push(raw[i]);
+      }
+    }
+  }
+
+  // whether the history and the chunk all hold the same value, as SlidingDifference::settled
+  bool settled(const double* in, int n) const {
+    const double x = in[0];
+    if (mHistory[0] != x || mHistory[1] != x || mHistory[2] != x || mHistory[3] != x) {
+      return false;
+    }
+    double moved = 0.;
+    for (int i = 0; i < n; ++i) {
+      moved += in[i] == x ? 0. : 1.;
+    }
+    return moved == 0.;
+  }
+
+  // loads an order's window from the history, and primes its table.
+  // the second order's output is delayed a sample, so the one it would have given on the last input is needed too
+  void start(int order) {
+    if (order == 2) {
+      load(mSecond);
+      mSecond.template prime<2>();
+      mLastSecond = d2<Shaper, 2>(mSecond.shaper(), mHistory[0], mHistory[1], mHistory[2],
+                                  epsilon<double>(mSecond.shaper()));
+    } else if (order == 4) {
+      load(mFourth);
+      mFourth.template prime<4>();
+    }
+  }
+
+  void load(SlidingDifference<Shaper>& difference) const {
+    for (int age = 3; age >= 0; --age) {
+      difference.window().push(mHistory[age]);
+    }
+  }
+
+  // the wet signal at one order, delayed to the fourth order's latency
+  void shape(int order, const double* in, float* out, int n) {
+    if (order == 4) {
+      mFourth.template nextBlock<4>(in, out, n);
+    } else if (order == 2) {
+      double second[kChunk];
+      mSecond.template nextBlock<2>(in, second, n);
+      out[0] = static_cast<float>(mLastSecond);
+      for (int i = 1; i < n; ++i) {
+        out[i] = static_cast<float>(second[i - 1]);
+      }
+      mLastSecond = second[n - 1];
+    } else {
+      const Shaper& shaper = mFourth.shaper();
+      for (int i = 0; i < n; ++i) {
+        const double x = i < 2 ? mHistory[1 - i] : in[i - 2];
+        out[i] = static_cast<float>(shaper.waveshape0(x));
+      }
+    }
+  }
+
+  // the order the last chunk ended at
+  int mOrder = 4;
+  // chunks in a row that have asked for a lower order than mOrder
+  int mCalm = 0;
+  // the control-rate gain at the end of the last block
+  float mGain;
+  // the second order's output for the last input, which is the first it gives in the next chunk
+  double mLastSecond = 0.;
+  // gain-scaled inputs, whichever order is running, to load a table from when it starts
+  History<double> mHistory;
+  // unscaled inputs, for the dry signal
+  History<> mInput;
+  SlidingDifference<Shaper> mSecond;
+  SlidingDifference<Shaper> mFourth;
+};
+
+} // namespace DADAA_TARGET
+} // namespace DADAA
@@ -0,0 +1,77 @@
+// BranchCounts.hpp
+// Rylee Alanza Lyman (ryleealanza@gmail.com)
+//
+// opt-in counts of which fallback branches the differences take.
+// the cost of a difference depends heavily on its branch, so these show where the time goes on real material.
+// they are compiled out unless DADAA_BRANCH_COUNTS is defined (the BRANCH_COUNTS CMake option).
+
+#pragma once
+
+#include "Target.hpp"
+
+#include <cstdint>
+
+namespace DADAA {
+inline namespace DADAA_TARGET {
+
+// the fallback branches of d1 to d4: some of their inputs within epsilon of each other, and merged (see dClose),
+// or all of them, which leaves a single node.
+// the counts are reported in this order.
+enum Branch : int {
+  kD1Close,
+  kD2Close,
+  kD2CloseAll,
+  kD3Close,
+  kD3CloseAll,
+  kD4Close,
+  kD4CloseAll,
+  // not branches: samples whose windows lay in one piece of the shaper, which skip the quotients for a closed form,
+  // samples through the difference kernels, and samples skipped because the input was constant
+  kInPiece,
+  kSamples,
+  kSettled,
+  kBranches
+};
+
+#ifdef DADAA_BRANCH_COUNTS
+
+struct BranchCounts {
+  uint64_t hits[kBranches] = {};
+};
+
+// the counts of the unit running on this thread, if any
+inline thread_local BranchCounts* tBranchCounts = nullptr;
+
+inline void countBranch(Branch branch, int n = 1) {
+  if (tBranchCounts != nullptr) {
+    tBranchCounts->hits[branch] += n;
+  }
+}
+
+// directs the counts on this thread to counts while it is in scope
+class BranchCountScope {
+public:
+  explicit BranchCountScope(BranchCounts& counts) : mPrevious(tBranchCounts) { tBranchCounts = &counts; }
+  ~BranchCountScope() { tBranchCounts = mPrevious; }
+  BranchCountScope(const BranchCountScope&) = delete;
+  BranchCountScope& operator=(const BranchCountScope&) = delete;
+
+private:
+  BranchCounts* mPrevious;
+};
+
+#else
+
+struct BranchCounts {};
+
+inline void countBranch(Branch, int = 1) {}
+
+class BranchCountScope {
+public:
+  explicit BranchCountScope(BranchCounts&) {}
+};
+
+#endif
+
+} // namespace DADAA_TARGET
+} // namespace DADAA
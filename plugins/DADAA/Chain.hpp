@@ -0,0 +1,189 @@
+// Chain.hpp
+// Rylee Alanza Lyman (ryleealanza@gmail.com)
+//
+// a whole distortion chain in one pass: a tilt EQ ahead of the shaper, a DC blocker after it,
+// and an equal-power crossfade from the dry signal to the result.
+// built from separate UGens, each stage would read its input from a wire buffer and write its output to another;
+// here each chunk goes through every stage from arrays on the stack, which stay in L1 cache,
+// and the shaper's differences run over whole chunks with the same kernels as Distortion.
+
+#pragma once
+
+#include "Kernels.hpp"
+#include "Target.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace DADAA {
+inline namespace DADAA_TARGET {
+
+// the controls of a DistortionChain besides its gain
+struct ChainControls {
+  // the tilt, in dB: positive boosts above the pivot and cuts below it by half as much each
+  float tilt = 0.f;
+  // the pivot of the tilt, in Hz
+  float pivot = 1000.f;
+  // added to the input after the tilt and gain, for asymmetric shaping
+  float bias = 0.f;
+  // -1 for the dry signal alone, 1 for the shaped one alone, as the pan of XFade2
+  float mix = 1.f;
+};
+
+// tilt, gain and bias, then anti-aliased waveshaping with Shaper, then a DC blocker,
+// then mixed with the input delayed by the whole part of the shaper's latency, as Distortion's dry signal is.
+// the tilt is a one-pole split around its pivot, so it adds no latency of its own.
+// the gain may run at audio rate; the other controls are ramped linearly across each block,
+// except the pivot, which moves from block to block.
+// the order should stay the same from block to block.
+template <class Shaper>
+class DistortionChain {
+public:
+  explicit DistortionChain(double sampleRate = 48000., float gain = 0.f, const ChainControls& controls = {},
+                           const Shaper& shaper = Shaper()) :
+    mSampleRate(sampleRate),
+    mBlockerPole(std::exp(-kTwoPi * kBlockerCorner / sampleRate)),
+    mGain(gain),
+    mLowGain(tiltGain(-controls.tilt)),
+    mHighGain(tiltGain(controls.tilt)),
+    mBias(controls.bias),
+    mDryGain(std::cos(mixAngle(controls.mix))),
+    mWetGain(std::sin(mixAngle(controls.mix))),
+    mDifference(shaper) {}
+
+  // gain at control or scalar rate, ramped as Distortion ramps it
+  template <int Order>
+  void process(const float* input, float gain, const ChainControls& controls, float* out, int nSamples) {
+    if (gain == mGain) {
+      const double constant = gain;
+      run<Order>(input, [constant](int) { return constant; }, controls, out, nSamples);
+    } else {
+      const double start = mGain;
+      const double slope = (static_cast<double>(gain) - start) / nSamples;
+      mGain = gain;
+      run<Order>(input, [start, slope](int i) { return start + slope * i; }, controls, out, nSamples);
+    }
+  }
+
+  // gain at audio rate, one value per sample
+  template <int Order>
+  void process(const float* input, const float* gain, const ChainControls& controls, float* out, int nSamples) {
+    run<Order>(input, [gain](int i) { return static_cast<double>(gain[i]); }, controls, out, nSamples);
+  }
+
+  // the delay of the shaped signal at a given order, in samples
+  static constexpr double latency(int order) { return 0.5 * order; }
+
+private:
+  static constexpr int kChunk = 64;
+  static constexpr double kTwoPi = 6.283185307179586;
+  static constexpr double kHalfPi = 1.5707963267948966;
+  // the DC blocker's corner, in Hz
+  static constexpr double kBlockerCorner = 10.;
+
+  // a control moving linearly from its value at the last block to its new one across this block
+  struct Ramp {
+    double start;
+    double slope;
+    double at(int i) const { return start + slope * i; }
+  };
+
+  static Ramp rampTo(double& last, double next, int nSamples) {
+    const Ramp ramp = {last, (next - last) / nSamples};
+    last = next;
+    return ramp;
+  }
+
+  static double tiltGain(float db) { return std::pow(10., db / 40.); }
+  static double mixAngle(float mix) {
+    const double clamped = mix < -1.f ? -1. : mix > 1.f ? 1. : mix;
+    return 0.5 * kHalfPi * (clamped + 1.);
+  }
+
+  template <int Order, class Gain>
+  void run(const float* input, Gain gainAt, const ChainControls& controls, float* out, int nSamples) {
+    if (mOrder != Order) {
+      mOrder = Order;
+      mDifference.template prime<Order>();
+    }
+    const double pivot = controls.pivot < 1.f ? 1. : std::min<double>(controls.pivot, 0.45 * mSampleRate);
+    const double lowpassPole = std::exp(-kTwoPi * pivot / mSampleRate);
+    const Ramp low = rampTo(mLowGain, tiltGain(-controls.tilt), nSamples);
+    const Ramp high = rampTo(mHighGain, tiltGain(controls.tilt), nSamples);
+    const Ramp bias = rampTo(mBias, controls.bias, nSamples);
+    const Ramp dryGain = rampTo(mDryGain, std::cos(mixAngle(controls.mix)), nSamples);
+    const Ramp wetGain = rampTo(mWetGain, std::sin(mixAngle(controls.mix)), nSamples);
+
+    // work from copies of the input, since the server may hand us an output buffer aliasing it
+    constexpr int delay = Order / 2;
+    for (int offset = 0; offset < nSamples; offset += kChunk) {
+      const int count = nSamples - offset < kChunk ? nSamples - offset : kChunk;
+      float raw[kChunk];
+      double scaled[kChunk];
+      double shaped[kChunk];
+
+      // the tilt, gain and bias, all in one loop
+      double lowpass = mLowpass;
+      for (int i = 0; i < count; ++i) {
+        const int at = offset + i;
+        raw[i] = input[at];
+        const double x = raw[i];
+        lowpass = x + lowpassPole * (lowpass - x);
+        const double tilted = low.at(at) * lowpass + high.at(at) * (x - lowpass);
+        scaled[i] = flushDenormal(tilted * gainAt(at) + bias.at(at));
+      }
+      mLowpass = flushDenormal(lowpass);
+
+      if (mDifference.settled(scaled, count)) {
+        countBranch(kSettled, count);
+        const double held = mDifference.shaper().waveshape0(mDifference.window()[0]);
+        for (int i = 0; i < count; ++i) {
+          shaped[i] = held;
+        }
+      } else {
+        countBranch(kSamples, count);
+        mDifference.template nextBlock<Order>(scaled, shaped, count);
+      }
+
+      // the DC blocker and the mix, again in one loop
+      double blockerIn = mBlockerIn;
+      double blockerOut = mBlockerOut;
+      for (int i = 0; i < count; ++i) {
+        const int at = offset + i;
+        blockerOut = shaped[i] - blockerIn + mBlockerPole * blockerOut;
+        blockerIn = shaped[i];
+        const double dry = i < delay ? mInput[delay - 1 - i] : raw[i - delay];
+        out[at] = static_cast<float>(dryGain.at(at) * dry + wetGain.at(at) * blockerOut);
+      }
+      mBlockerIn = blockerIn;
+      mBlockerOut = flushDenormal(blockerOut);
+
+      for (int i = count < 4 ? 0 : count - 4; i < count; ++i) {
+        mInput.push(raw[i]);
+      }
+    }
+  }
+
+  double mSampleRate;
+  double mBlockerPole;
+  // the order the table was last primed for
+  int mOrder = 4;
+  // the control-rate values at the end of the last block
+  float mGain;
+  double mLowGain;
+  double mHighGain;
+  double mBias;
+  double mDryGain;
+  double mWetGain;
+  // the tilt's lowpass, and the DC blocker's last input and output
+  double mLowpass = 0.;
+  double mBlockerIn = 0.;
+  double mBlockerOut = 0.;
+  // unscaled inputs, for the dry signal
+  History<> mInput;
+  // tilted, gain-scaled and biased inputs and their differences
+  SlidingDifference<Shaper> mDifference;
+};
+
+} // namespace DADAA_TARGET
+} // namespace DADAA
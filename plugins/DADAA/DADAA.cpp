@@ -1,66 +1,52 @@
 // PluginDADAA.cpp
 // Rylee Alanza Lyman (ryleealanza@gmail.com)
+//
+// the units built for the baseline of the platform (SSE2 on x86-64), and the choice between them
+// and the builds for wider instruction sets at load.
 
-#include "SC_PlugIn.hpp"
-#include "DADAA.hpp"
+#include "DADAAUnits.hpp"
 
-static InterfaceTable* ft;
+#include <cstdlib>
+#include <cstring>
 
 namespace DADAA {
 
-CADAA::CADAA() {
-  mCalcFunc = make_calc_function<CADAA, &CADAA::next>();
-  next(1);
-}
-
-TADAA::TADAA() {
-  mCalcFunc = make_calc_function<TADAA, &TADAA::next>();
-  next(1);
-}
-
-void CADAA::next(int nSamples) {
-  const float* input = in(0);
-  const float gain = in0(1);
-  float* wet = out(0);
-  float* dry = out(1);
-
-  // anti-aliased hard clipping function
-  for (int i = 0; i < nSamples; ++i) {
-    mLastLast = mLast;
-    mLast = mCurrent;
-    mCurrent = mNext;
-    mNext = mNextNext;
-    mNextNext = input[i];
-    dry[i] = mCurrent;
-    wet[i] = DADAA::d4(mNextNext * gain, mNext * gain, mCurrent * gain, mLast * gain, mLastLast * gain, 
-                       mEps, waveshape4, waveshape3, waveshape2, waveshape1, waveshape0);
+#ifdef DADAA_DISPATCH
+// whether the environment variable DADAA_TARGET, if set, allows target: it names the widest one to use,
+// e.g. generic to compare the builds on one machine
+static bool allowed(const char* target) {
+  static const char* const kTargets[] = {"generic", "avx2", "avx512"};
+  const char* requested = std::getenv("DADAA_TARGET");
+  if (requested == nullptr) {
+    return true;
   }
-}
-
-void TADAA::next(int nSamples) {
-    const float* input = in(0);
-    const float gain = in0(1);
-    float* wet = out(0);
-    float* dry = out(1);
-
-    // anti-aliased tanh saturation function
-    for (int i = 0; i < nSamples; ++i) {
-      mLastLast = mLast;
-      mLast = mCurrent;
-      mCurrent = mNext;
-      mNext = mNextNext;
-      mNextNext = input[i];
-      dry[i] = mCurrent;
-      wet[i] = DADAA::d4(mNextNext * gain, mNext * gain, mCurrent * gain, mLast * gain, mLastLast * gain,
-                         mEps, waveshape4, waveshape3, waveshape2, waveshape1, waveshape0);
+  for (const char* each : kTargets) {
+    if (std::strcmp(each, target) == 0) {
+      return true;
+    }
+    if (std::strcmp(each, requested) == 0) {
+      return false;
     }
+  }
+  return true;
 }
+#endif
 
 } // namespace DADAA
 
 PluginLoad(DADAAUGens) {
   // Plugin magic
-  ft = inTable;
-  registerUnit<DADAA::CADAA>(ft, "CADAA", false);
-  registerUnit<DADAA::TADAA>(ft, "TADAA", false);
+#ifdef DADAA_DISPATCH
+  __builtin_cpu_init();
+  if (DADAA::allowed("avx512") && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") &&
+      __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512bw")) {
+    DADAA::registerAVX512Units(inTable);
+    return;
+  }
+  if (DADAA::allowed("avx2") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    DADAA::registerAVX2Units(inTable);
+    return;
+  }
+#endif
+  DADAA::registerUnits(inTable);
 }
@@ -1,25 +1,320 @@
 TADAA : MultiOutUGen {
-	*ar { |input, gain|
-		^this.multiNew('audio', input, gain);
+	*ar { |input, gain, order = 4, single = 0, oversample = 1, adaptive = 0|
+		^this.multiNew('audio', input, gain, order, single, oversample, adaptive);
+	}
+	// one value per control period; there is no oversampling or adaptive order at control rate
+	*kr { |input, gain, order = 4, single = 0|
+		^this.multiNew('control', input, gain, order, single, 1, 0);
+	}
+	// the delay of the wet signal, in samples; the adaptive order always has the fourth order's
+	*latency { |order = 4, oversample = 1, adaptive = 0|
+		^case
+		{ adaptive != 0 } { 2 }
+		{ oversample < 2 } { order / 2 }
+		{ oversample < 4 } { 32 + (order / 4) }
+		{ 37 + (order / 8) };
+	}
+	// the wet signal alone, without the delayed dry copy: causal, see *latency
+	*arWet { |input, gain, order = 4, single = 0, oversample = 1, adaptive = 0|
+		^TADAAWet.ar(input, gain, order, single, oversample, adaptive);
+	}
+	*krWet { |input, gain, order = 4, single = 0|
+		^TADAAWet.kr(input, gain, order, single);
+	}
+	*arN { |inputs, gain, order = 4|
+		^TADAAN.ar(inputs, gain, order);
 	}
   init { arg ... theInputs;
     inputs = theInputs;
     ^this.initOutputs(2, rate);
   }
 	checkInputs {
+		if(inputs.at(2).rate != 'scalar') {
+			^(": order must be a fixed value, not" + inputs.at(2).rate)
+		};
+		if(inputs.at(3).rate != 'scalar') {
+			^(": single must be a fixed value, not" + inputs.at(3).rate)
+		};
+		if(inputs.at(4).rate != 'scalar') {
+			^(": oversample must be a fixed value, not" + inputs.at(4).rate)
+		};
+		if(inputs.at(5).rate != 'scalar') {
+			^(": adaptive must be a fixed value, not" + inputs.at(5).rate)
+		};
 		^this.checkValidInputs;
 	}
 }
 
 CADAA : MultiOutUGen {
-	*ar { |input, gain|
-		^this.multiNew('audio', input, gain);
+	*ar { |input, gain, order = 4, single = 0, oversample = 1, adaptive = 0|
+		^this.multiNew('audio', input, gain, order, single, oversample, adaptive);
+	}
+	// one value per control period; there is no oversampling or adaptive order at control rate
+	*kr { |input, gain, order = 4, single = 0|
+		^this.multiNew('control', input, gain, order, single, 1, 0);
+	}
+	// the delay of the wet signal, in samples; the adaptive order always has the fourth order's
+	*latency { |order = 4, oversample = 1, adaptive = 0|
+		^case
+		{ adaptive != 0 } { 2 }
+		{ oversample < 2 } { order / 2 }
+		{ oversample < 4 } { 32 + (order / 4) }
+		{ 37 + (order / 8) };
+	}
+	// the wet signal alone, without the delayed dry copy: causal, see *latency
+	*arWet { |input, gain, order = 4, single = 0, oversample = 1, adaptive = 0|
+		^CADAAWet.ar(input, gain, order, single, oversample, adaptive);
+	}
+	*krWet { |input, gain, order = 4, single = 0|
+		^CADAAWet.kr(input, gain, order, single);
+	}
+	*arN { |inputs, gain, order = 4|
+		^CADAAN.ar(inputs, gain, order);
+	}
+  init { arg ... theInputs;
+    inputs = theInputs;
+    ^this.initOutputs(2, rate);
+  }
+	checkInputs {
+		if(inputs.at(2).rate != 'scalar') {
+			^(": order must be a fixed value, not" + inputs.at(2).rate)
+		};
+		if(inputs.at(3).rate != 'scalar') {
+			^(": single must be a fixed value, not" + inputs.at(3).rate)
+		};
+		if(inputs.at(4).rate != 'scalar') {
+			^(": oversample must be a fixed value, not" + inputs.at(4).rate)
+		};
+		if(inputs.at(5).rate != 'scalar') {
+			^(": adaptive must be a fixed value, not" + inputs.at(5).rate)
+		};
+		^this.checkValidInputs;
+	}
+}
+
+ETADAA : MultiOutUGen {
+	*ar { |input, gain, order = 4, single = 0, oversample = 1, adaptive = 0|
+		^this.multiNew('audio', input, gain, order, single, oversample, adaptive);
+	}
+	// one value per control period; there is no oversampling or adaptive order at control rate
+	*kr { |input, gain, order = 4, single = 0|
+		^this.multiNew('control', input, gain, order, single, 1, 0);
+	}
+	// the delay of the wet signal, in samples; the adaptive order always has the fourth order's
+	*latency { |order = 4, oversample = 1, adaptive = 0|
+		^case
+		{ adaptive != 0 } { 2 }
+		{ oversample < 2 } { order / 2 }
+		{ oversample < 4 } { 32 + (order / 4) }
+		{ 37 + (order / 8) };
+	}
+	// the wet signal alone, without the delayed dry copy: causal, see *latency
+	*arWet { |input, gain, order = 4, single = 0, oversample = 1, adaptive = 0|
+		^ETADAAWet.ar(input, gain, order, single, oversample, adaptive);
+	}
+	*krWet { |input, gain, order = 4, single = 0|
+		^ETADAAWet.kr(input, gain, order, single);
 	}
   init { arg ... theInputs;
     inputs = theInputs;
     ^this.initOutputs(2, rate);
   }
 	checkInputs {
+		if(inputs.at(2).rate != 'scalar') {
+			^(": order must be a fixed value, not" + inputs.at(2).rate)
+		};
+		if(inputs.at(3).rate != 'scalar') {
+			^(": single must be a fixed value, not" + inputs.at(3).rate)
+		};
+		if(inputs.at(4).rate != 'scalar') {
+			^(": oversample must be a fixed value, not" + inputs.at(4).rate)
+		};
+		if(inputs.at(5).rate != 'scalar') {
+			^(": adaptive must be a fixed value, not" + inputs.at(5).rate)
+		};
+		^this.checkValidInputs;
+	}
+}
+
+TADAAN : MultiOutUGen {
+	*ar { |inputs, gain, order = 4|
+		inputs = inputs.asArray;
+		^this.multiNewList(['audio', gain, order] ++ inputs).clump(inputs.size);
+	}
+  init { arg ... theInputs;
+    inputs = theInputs;
+    ^this.initOutputs(2 * (inputs.size - 2), rate);
+  }
+	checkInputs {
+		if(inputs.at(1).rate != 'scalar') {
+			^(": order must be a fixed value, not" + inputs.at(1).rate)
+		};
+		^this.checkValidInputs;
+	}
+}
+
+CADAAN : MultiOutUGen {
+	*ar { |inputs, gain, order = 4|
+		inputs = inputs.asArray;
+		^this.multiNewList(['audio', gain, order] ++ inputs).clump(inputs.size);
+	}
+  init { arg ... theInputs;
+    inputs = theInputs;
+    ^this.initOutputs(2 * (inputs.size - 2), rate);
+  }
+	checkInputs {
+		if(inputs.at(1).rate != 'scalar') {
+			^(": order must be a fixed value, not" + inputs.at(1).rate)
+		};
+		^this.checkValidInputs;
+	}
+}
+
+PADAA : MultiOutUGen {
+	*ar { |bufnum, input, gain, order = 4|
+		^this.multiNew('audio', bufnum, input, gain, order);
+	}
+	// the contents of a Buffer for PADAA.
+	// breakpoints are the boundaries between the pieces, increasing,
+	// and pieces holds the coefficients of each piece, constant term first.
+	*table { |breakpoints, pieces|
+		var degree;
+		if(breakpoints.size != (pieces.size - 1)) {
+			Error("PADAA: there must be one more piece than breakpoints").throw;
+		};
+		degree = pieces.collect(_.size).maxItem - 1;
+		^[pieces.size, degree] ++ breakpoints ++ pieces.collect { |coefficients|
+			coefficients ++ (0 ! (degree + 1 - coefficients.size))
+		}.flatten;
+	}
+  init { arg ... theInputs;
+    inputs = theInputs;
+    ^this.initOutputs(2, rate);
+  }
+	checkInputs {
+		if(inputs.at(3).rate != 'scalar') {
+			^(": order must be a fixed value, not" + inputs.at(3).rate)
+		};
+		^this.checkValidInputs;
+	}
+}
+
+TADAAWet : UGen {
+	*ar { |input, gain, order = 4, single = 0, oversample = 1, adaptive = 0|
+		^this.multiNew('audio', input, gain, order, single, oversample, adaptive);
+	}
+	*kr { |input, gain, order = 4, single = 0|
+		^this.multiNew('control', input, gain, order, single, 1, 0);
+	}
+	checkInputs {
+		if(inputs.at(2).rate != 'scalar') {
+			^(": order must be a fixed value, not" + inputs.at(2).rate)
+		};
+		if(inputs.at(3).rate != 'scalar') {
+			^(": single must be a fixed value, not" + inputs.at(3).rate)
+		};
+		if(inputs.at(4).rate != 'scalar') {
+			^(": oversample must be a fixed value, not" + inputs.at(4).rate)
+		};
+		if(inputs.at(5).rate != 'scalar') {
+			^(": adaptive must be a fixed value, not" + inputs.at(5).rate)
+		};
+		^this.checkValidInputs;
+	}
+}
+
+CADAAWet : UGen {
+	*ar { |input, gain, order = 4, single = 0, oversample = 1, adaptive = 0|
+		^this.multiNew('audio', input, gain, order, single, oversample, adaptive);
+	}
+	*kr { |input, gain, order = 4, single = 0|
+		^this.multiNew('control', input, gain, order, single, 1, 0);
+	}
+	checkInputs {
+		if(inputs.at(2).rate != 'scalar') {
+			^(": order must be a fixed value, not" + inputs.at(2).rate)
+		};
+		if(inputs.at(3).rate != 'scalar') {
+			^(": single must be a fixed value, not" + inputs.at(3).rate)
+		};
+		if(inputs.at(4).rate != 'scalar') {
+			^(": oversample must be a fixed value, not" + inputs.at(4).rate)
+		};
+		if(inputs.at(5).rate != 'scalar') {
+			^(": adaptive must be a fixed value, not" + inputs.at(5).rate)
+		};
+		^this.checkValidInputs;
+	}
+}
+
+ETADAAWet : UGen {
+	*ar { |input, gain, order = 4, single = 0, oversample = 1, adaptive = 0|
+		^this.multiNew('audio', input, gain, order, single, oversample, adaptive);
+	}
+	*kr { |input, gain, order = 4, single = 0|
+		^this.multiNew('control', input, gain, order, single, 1, 0);
+	}
+	checkInputs {
+		if(inputs.at(2).rate != 'scalar') {
+			^(": order must be a fixed value, not" + inputs.at(2).rate)
+		};
+		if(inputs.at(3).rate != 'scalar') {
+			^(": single must be a fixed value, not" + inputs.at(3).rate)
+		};
+		if(inputs.at(4).rate != 'scalar') {
+			^(": oversample must be a fixed value, not" + inputs.at(4).rate)
+		};
+		if(inputs.at(5).rate != 'scalar') {
+			^(": adaptive must be a fixed value, not" + inputs.at(5).rate)
+		};
+		^this.checkValidInputs;
+	}
+}
+
+TADAAChain : UGen {
+	*ar { |input, gain, tilt = 0, freq = 1000, bias = 0, mix = 1, order = 4|
+		^this.multiNew('audio', input, gain, tilt, freq, bias, mix, order);
+	}
+	// the delay of the shaped signal, in samples
+	*latency { |order = 4|
+		^order / 2
+	}
+	checkInputs {
+		if(inputs.at(6).rate != 'scalar') {
+			^(": order must be a fixed value, not" + inputs.at(6).rate)
+		};
+		^this.checkValidInputs;
+	}
+}
+
+CADAAChain : UGen {
+	*ar { |input, gain, tilt = 0, freq = 1000, bias = 0, mix = 1, order = 4|
+		^this.multiNew('audio', input, gain, tilt, freq, bias, mix, order);
+	}
+	// the delay of the shaped signal, in samples
+	*latency { |order = 4|
+		^order / 2
+	}
+	checkInputs {
+		if(inputs.at(6).rate != 'scalar') {
+			^(": order must be a fixed value, not" + inputs.at(6).rate)
+		};
+		^this.checkValidInputs;
+	}
+}
+
+ETADAAChain : UGen {
+	*ar { |input, gain, tilt = 0, freq = 1000, bias = 0, mix = 1, order = 4|
+		^this.multiNew('audio', input, gain, tilt, freq, bias, mix, order);
+	}
+	// the delay of the shaped signal, in samples
+	*latency { |order = 4|
+		^order / 2
+	}
+	checkInputs {
+		if(inputs.at(6).rate != 'scalar') {
+			^(": order must be a fixed value, not" + inputs.at(6).rate)
+		};
 		^this.checkValidInputs;
 	}
 }
@@ -0,0 +1,394 @@
+// DADAAUnits.hpp
+// Rylee Alanza Lyman (ryleealanza@gmail.com)
+//
+// the units themselves, built once for each target by DADAA.cpp, DADAA_AVX2.cpp and DADAA_AVX512.cpp.
+// each of those includes this once, after choosing its target.
+
+#pragma once
+
+#include "SC_PlugIn.hpp"
+#include "DADAA.hpp"
+
+#include <algorithm>
+#include <new>
+#include <type_traits>
+
+// one per translation unit, and so one per target, set by its registerUnits
+static InterfaceTable* ft;
+
+namespace DADAA {
+inline namespace DADAA_TARGET {
+
+template <class Unit, int Order, bool AudioRateGain, class Real>
+UnitCalcFunc calcFunction() {
+  // orders past kMaxSingleOrder are only built in double
+  if constexpr (std::is_same_v<Real, float> && Order <= kMaxSingleOrder) {
+    return SCUnit::make_calc_function<Unit, &Unit::template next<Order, AudioRateGain, float>>();
+  } else {
+    return SCUnit::make_calc_function<Unit, &Unit::template next<Order, AudioRateGain>>();
+  }
+}
+
+// the calc function for an order from 0 to 4
+template <class Unit, bool AudioRateGain, class Real>
+UnitCalcFunc calcFunctionForOrder(int order) {
+  switch (std::clamp(order, 0, 4)) {
+  case 0:
+    return calcFunction<Unit, 0, AudioRateGain, Real>();
+  case 1:
+    return calcFunction<Unit, 1, AudioRateGain, Real>();
+  case 2:
+    return calcFunction<Unit, 2, AudioRateGain, Real>();
+  case 3:
+    return calcFunction<Unit, 3, AudioRateGain, Real>();
+  default:
+    return calcFunction<Unit, 4, AudioRateGain, Real>();
+  }
+}
+
+// audio-rate gain is applied sample by sample, otherwise it is ramped from block to block
+template <class Unit, class Real = double>
+UnitCalcFunc calcFunctionFor(int order, bool audioRateGain) {
+  if (audioRateGain) {
+    return calcFunctionForOrder<Unit, true, Real>(order);
+  }
+  return calcFunctionForOrder<Unit, false, Real>(order);
+}
+
+template <class Unit, int Order, class Real>
+UnitCalcFunc controlCalcFunction() {
+  if constexpr (std::is_same_v<Real, float> && Order <= kMaxSingleOrder) {
+    return SCUnit::make_calc_function<Unit, &Unit::template nextControl<Order, float>>();
+  } else {
+    return SCUnit::make_calc_function<Unit, &Unit::template nextControl<Order>>();
+  }
+}
+
+// the control-rate calc function for an order from 0 to 4
+template <class Unit, class Real = double>
+UnitCalcFunc controlCalcFunctionFor(int order) {
+  switch (std::clamp(order, 0, 4)) {
+  case 0:
+    return controlCalcFunction<Unit, 0, Real>();
+  case 1:
+    return controlCalcFunction<Unit, 1, Real>();
+  case 2:
+    return controlCalcFunction<Unit, 2, Real>();
+  case 3:
+    return controlCalcFunction<Unit, 3, Real>();
+  default:
+    return controlCalcFunction<Unit, 4, Real>();
+  }
+}
+
+// the oversample input of CADAA and TADAA, 1 if it is missing or the unit runs at control rate
+static int oversampleFactor(SCUnit* unit) {
+  if (unit->mCalcRate != calc_FullRate) {
+    return 1;
+  }
+  return unit->numInputs() > 4 ? static_cast<int>(unit->in0(4)) : 1;
+}
+
+template <class Shaper>
+ADAAUnit<Shaper>::ADAAUnit() {
+  const int order = numInputs() > 2 ? static_cast<int>(in0(2)) : 4;
+  const bool single = numInputs() > 3 && in0(3) != 0.f;
+  const bool adaptive = numInputs() > 5 && in0(5) != 0.f;
+  // orders past kMaxSingleOrder run in double whatever single says, as calcFunction picks them
+  const bool inFloat = single && std::clamp(order, 0, 4) <= kMaxSingleOrder;
+  const int factor = oversampleFactor(this);
+  bool allocated = true;
+  if (mCalcRate == calc_FullRate && adaptive) {
+    allocated = allocate<AdaptiveDistortion<Shaper>>(in0(1));
+  } else if (factor > 1) {
+    allocated = inFloat ? allocate<OversampledDistortion<Shaper, float>>(in0(1), factor)
+                        : allocate<OversampledDistortion<Shaper>>(in0(1), factor);
+  } else if (inFloat) {
+    mEngine.template emplace<Distortion<Shaper, float>>(in0(1));
+  } else {
+    mEngine.template emplace<Distortion<Shaper>>(in0(1));
+  }
+  if (!allocated) {
+    Print("DADAA: alloc failed, increase server's RT memory (e.g. via ServerOptions)\n");
+    mCalcFunc = ft->fClearUnitOutputs;
+    ClearUnitOutputs(this, 1);
+    return;
+  }
+  if (mCalcRate != calc_FullRate) {
+    mCalcFunc = single ? controlCalcFunctionFor<ADAAUnit, float>(order) : controlCalcFunctionFor<ADAAUnit>(order);
+  } else if (adaptive) {
+    mCalcFunc = isAudioRateIn(1) ? make_calc_function<ADAAUnit, &ADAAUnit::nextAdaptive<true>>()
+                                 : make_calc_function<ADAAUnit, &ADAAUnit::nextAdaptive<false>>();
+  } else if (single) {
+    mCalcFunc = calcFunctionFor<ADAAUnit, float>(order, isAudioRateIn(1));
+  } else {
+    mCalcFunc = calcFunctionFor<ADAAUnit>(order, isAudioRateIn(1));
+  }
+  (mCalcFunc)(this, 1);
+}
+
+template <class Shaper>
+ADAAUnit<Shaper>::~ADAAUnit() {
+  // the engines from RTAlloc are trivially destructible, and only need freeing
+  void* allocated = nullptr;
+  if (auto* engine = std::get_if<OversampledDistortion<Shaper>*>(&mEngine)) {
+    allocated = *engine;
+  } else if (auto* engine = std::get_if<OversampledDistortion<Shaper, float>*>(&mEngine)) {
+    allocated = *engine;
+  } else if (auto* engine = std::get_if<AdaptiveDistortion<Shaper>*>(&mEngine)) {
+    allocated = *engine;
+  }
+  if (allocated != nullptr) {
+    RTFree(mWorld, allocated);
+  }
+}
+
+template <class Shaper>
+template <class Engine>
+Engine& ADAAUnit<Shaper>::engine() {
+  if constexpr (std::is_same_v<Engine, Distortion<Shaper>> || std::is_same_v<Engine, Distortion<Shaper, float>>) {
+    return *std::get_if<Engine>(&mEngine);
+  } else {
+    return **std::get_if<Engine*>(&mEngine);
+  }
+}
+
+template <class Shaper>
+template <class Engine, class... Args>
+bool ADAAUnit<Shaper>::allocate(Args... args) {
+  static_assert(std::is_trivially_destructible_v<Engine>, "the unit frees its engine without destroying it");
+  void* memory = RTAlloc(mWorld, sizeof(Engine));
+  if (memory == nullptr) {
+    return false;
+  }
+  mEngine.template emplace<Engine*>(new (memory) Engine(args...));
+  return true;
+}
+
+template <class Shaper>
+template <int Order, bool AudioRateGain, class Real>
+void ADAAUnit<Shaper>::next(int nSamples) {
+  // anti-aliased waveshaping of the given order, in the given precision
+  BranchCountScope counting(mCounts);
+  float* dry = numOutputs() > 1 ? out(1) : nullptr;
+  auto run = [&](auto& engine) {
+    if constexpr (AudioRateGain) {
+      engine.template process<Order>(in(0), in(1), out(0), dry, nSamples);
+    } else {
+      engine.template process<Order>(in(0), in0(1), out(0), dry, nSamples);
+    }
+  };
+  if (std::holds_alternative<OversampledDistortion<Shaper, Real>*>(mEngine)) {
+    run(engine<OversampledDistortion<Shaper, Real>>());
+  } else {
+    run(engine<Distortion<Shaper, Real>>());
+  }
+}
+
+template <class Shaper>
+template <int Order, class Real>
+void ADAAUnit<Shaper>::nextControl(int) {
+  // one value per control period, with the history kept from one to the next
+  BranchCountScope counting(mCounts);
+  float* dry = numOutputs() > 1 ? out(1) : nullptr;
+  out0(0) = engine<Distortion<Shaper, Real>>().template next<Order>(in0(0), in0(1), dry);
+}
+
+template <class Shaper>
+template <bool AudioRateGain>
+void ADAAUnit<Shaper>::nextAdaptive(int nSamples) {
+  // orders 0, 2 and 4, chosen chunk by chunk
+  BranchCountScope counting(mCounts);
+  float* dry = numOutputs() > 1 ? out(1) : nullptr;
+  auto& adaptive = engine<AdaptiveDistortion<Shaper>>();
+  if constexpr (AudioRateGain) {
+    adaptive.process(in(0), in(1), out(0), dry, nSamples);
+  } else {
+    adaptive.process(in(0), in0(1), out(0), dry, nSamples);
+  }
+}
+
+template <class Shaper>
+ADAAMultiUnit<Shaper>::ADAAMultiUnit() {
+  mChannels = numInputs() - 2;
+  const size_t size = MultiDistortion<Shaper>::storageSize(mChannels) * sizeof(double);
+  mStorage = static_cast<double*>(RTAlloc(mWorld, size));
+  if (mStorage == nullptr) {
+    Print("DADAA: alloc failed, increase server's RT memory (e.g. via ServerOptions)\n");
+    mCalcFunc = ft->fClearUnitOutputs;
+    ClearUnitOutputs(this, 1);
+    return;
+  }
+  mDistortion = MultiDistortion<Shaper>(mStorage, mChannels, in0(0));
+  mCalcFunc = calcFunctionFor<ADAAMultiUnit>(static_cast<int>(in0(1)), isAudioRateIn(0));
+  (mCalcFunc)(this, 1);
+}
+
+template <class Shaper>
+ADAAMultiUnit<Shaper>::~ADAAMultiUnit() {
+  if (mStorage != nullptr) {
+    RTFree(mWorld, mStorage);
+  }
+}
+
+template <class Shaper>
+template <int Order, bool AudioRateGain>
+void ADAAMultiUnit<Shaper>::next(int nSamples) {
+  // every channel, each through its own Distortion
+  BranchCountScope counting(mCounts);
+  if constexpr (AudioRateGain) {
+    mDistortion.template process<Order>(mInBuf + 2, in(0), mOutBuf, mOutBuf + mChannels, nSamples);
+  } else {
+    mDistortion.template process<Order>(mInBuf + 2, in0(0), mOutBuf, mOutBuf + mChannels, nSamples);
+  }
+}
+
+// the buffer a bufnum input refers to, found as GET_BUF does
+static SndBuf* bufferFor(Unit* unit, float fbufnum) {
+  const uint32 bufnum = fbufnum < 0.f ? 0 : static_cast<uint32>(fbufnum);
+  World* world = unit->mWorld;
+  if (bufnum >= world->mNumSndBufs) {
+    const uint32 localBufNum = bufnum - world->mNumSndBufs;
+    Graph* parent = unit->mParent;
+    if (localBufNum <= parent->localBufNum) {
+      return parent->mLocalSndBufs + localBufNum;
+    }
+    return world->mSndBufs;
+  }
+  return world->mSndBufs + bufnum;
+}
+
+PADAA::PADAA() : mStorage(nullptr) {
+  // the table is read once: its anti-derivatives are worked out here rather than per sample
+  SndBuf* buf = bufferFor(this, in0(0));
+  LOCK_SNDBUF_SHARED(buf);
+  const char* error = buf->data == nullptr ? "the buffer is empty" : PolynomialShaper::check(buf->data, buf->samples);
+  if (error == nullptr) {
+    const size_t size = PolynomialShaper::storageSize(buf->data) * sizeof(double);
+    mStorage = static_cast<double*>(RTAlloc(mWorld, size));
+    if (mStorage == nullptr) {
+      error = "alloc failed, increase server's RT memory (e.g. via ServerOptions)";
+    } else {
+      mDistortion = Distortion<PolynomialShaper>(in0(2), PolynomialShaper(mStorage, buf->data));
+    }
+  }
+  RELEASE_SNDBUF_SHARED(buf);
+  if (error != nullptr) {
+    Print("PADAA: %s\n", error);
+    mCalcFunc = ft->fClearUnitOutputs;
+    ClearUnitOutputs(this, 1);
+    return;
+  }
+  const int order = numInputs() > 3 ? static_cast<int>(in0(3)) : 4;
+  mCalcFunc = calcFunctionFor<PADAA>(order, isAudioRateIn(2));
+  (mCalcFunc)(this, 1);
+}
+
+PADAA::~PADAA() {
+  if (mStorage != nullptr) {
+    RTFree(mWorld, mStorage);
+  }
+}
+
+template <int Order, bool AudioRateGain>
+void PADAA::next(int nSamples) {
+  BranchCountScope counting(mCounts);
+  if constexpr (AudioRateGain) {
+    mDistortion.template process<Order>(in(1), in(2), out(0), out(1), nSamples);
+  } else {
+    mDistortion.template process<Order>(in(1), in0(2), out(0), out(1), nSamples);
+  }
+}
+
+template <class Shaper>
+ChainUnit<Shaper>::ChainUnit() : mChain(sampleRate(), in0(1), controls()) {
+  mCalcFunc = calcFunctionFor<ChainUnit>(static_cast<int>(in0(6)), isAudioRateIn(1));
+  (mCalcFunc)(this, 1);
+}
+
+template <class Shaper>
+ChainControls ChainUnit<Shaper>::controls() {
+  ChainControls controls;
+  controls.tilt = in0(2);
+  controls.pivot = in0(3);
+  controls.bias = in0(4);
+  controls.mix = in0(5);
+  return controls;
+}
+
+template <class Shaper>
+template <int Order, bool AudioRateGain>
+void ChainUnit<Shaper>::next(int nSamples) {
+  BranchCountScope counting(mCounts);
+  if constexpr (AudioRateGain) {
+    mChain.template process<Order>(in(0), in(1), controls(), out(0), nSamples);
+  } else {
+    mChain.template process<Order>(in(0), in0(1), controls(), out(0), nSamples);
+  }
+}
+
+#ifdef DADAA_BRANCH_COUNTS
+template <class Unit>
+void replyBranchCounts(::Unit* unit, sc_msg_iter* args) {
+  Unit* self = static_cast<Unit*>(unit);
+  const int replyID = args->geti(-1);
+  // floats are what a reply can carry; counting since the last reply keeps them exact for a while
+  float counts[kBranches];
+  for (int branch = 0; branch < kBranches; ++branch) {
+    counts[branch] = static_cast<float>(self->mCounts.hits[branch]);
+    self->mCounts.hits[branch] = 0;
+  }
+  SendNodeReply(&self->mParent->mNode, replyID, "/dadaa_counts", kBranches, counts);
+}
+#endif
+
+// these need to be user-provided: the server value-initializes units,
+// which would otherwise zero the fields it has already filled in
+CADAA::CADAA() {}
+
+TADAA::TADAA() {}
+
+ETADAA::ETADAA() {}
+
+CADAAN::CADAAN() {}
+
+TADAAN::TADAAN() {}
+
+CADAAChain::CADAAChain() {}
+
+TADAAChain::TADAAChain() {}
+
+ETADAAChain::ETADAAChain() {}
+
+void registerUnits(InterfaceTable* inTable) {
+  ft = inTable;
+  registerUnit<CADAA>(ft, "CADAA", false);
+  registerUnit<TADAA>(ft, "TADAA", false);
+  registerUnit<CADAAN>(ft, "CADAAN", false);
+  registerUnit<TADAAN>(ft, "TADAAN", false);
+  registerUnit<PADAA>(ft, "PADAA", false);
+  registerUnit<CADAA>(ft, "CADAAWet", false);
+  registerUnit<TADAA>(ft, "TADAAWet", false);
+  registerUnit<ETADAA>(ft, "ETADAA", false);
+  registerUnit<ETADAA>(ft, "ETADAAWet", false);
+  registerUnit<CADAAChain>(ft, "CADAAChain", false);
+  registerUnit<TADAAChain>(ft, "TADAAChain", false);
+  registerUnit<ETADAAChain>(ft, "ETADAAChain", false);
+#ifdef DADAA_BRANCH_COUNTS
+  DefineUnitCmd("CADAA", "counts", replyBranchCounts<CADAA>);
+  DefineUnitCmd("TADAA", "counts", replyBranchCounts<TADAA>);
+  DefineUnitCmd("CADAAN", "counts", replyBranchCounts<CADAAN>);
+  DefineUnitCmd("TADAAN", "counts", replyBranchCounts<TADAAN>);
+  DefineUnitCmd("PADAA", "counts", replyBranchCounts<PADAA>);
+  DefineUnitCmd("CADAAWet", "counts", replyBranchCounts<CADAA>);
+  DefineUnitCmd("TADAAWet", "counts", replyBranchCounts<TADAA>);
+  DefineUnitCmd("ETADAA", "counts", replyBranchCounts<ETADAA>);
+  DefineUnitCmd("ETADAAWet", "counts", replyBranchCounts<ETADAA>);
+  DefineUnitCmd("CADAAChain", "counts", replyBranchCounts<CADAAChain>);
+  DefineUnitCmd("TADAAChain", "counts", replyBranchCounts<TADAAChain>);
+  DefineUnitCmd("ETADAAChain", "counts", replyBranchCounts<ETADAAChain>);
+#endif
+}
+
+} // namespace DADAA_TARGET
+} // namespace DADAA
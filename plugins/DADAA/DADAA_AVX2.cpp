@@ -0,0 +1,31 @@
+// DADAA_AVX2.cpp
+// Rylee Alanza Lyman (ryleealanza@gmail.com)
+//
+// the units built for AVX2 and FMA, registered in place of the baseline ones on CPUs that have them (see DADAA.cpp).
+// SuperCollider's headers and the standard ones are included before the target changes, so that only
+// the kernels and units, in their own namespace (see Target.hpp), are built for it.
+
+#include "SC_PlugIn.hpp"
+#define DADAA_TARGET avx2
+#include "Target.hpp"
+
+#ifdef DADAA_DISPATCH
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+#include "DADAAUnits.hpp"
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+void DADAA::registerAVX2Units(InterfaceTable* inTable) { registerUnits(inTable); }
+
+#endif
@@ -0,0 +1,32 @@
+// DADAA_AVX512.cpp
+// Rylee Alanza Lyman (ryleealanza@gmail.com)
+//
+// the units built for AVX-512, registered in place of the baseline ones on CPUs that have them (see DADAA.cpp).
+// SuperCollider's headers and the standard ones are included before the target changes, so that only
+// the kernels and units, in their own namespace (see Target.hpp), are built for it.
+
+#include "SC_PlugIn.hpp"
+#define DADAA_TARGET avx512
+#include "Target.hpp"
+
+#ifdef DADAA_DISPATCH
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f,avx512vl,avx512dq,avx512bw,avx2,fma"))), \
+                             apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512vl,avx512dq,avx512bw,avx2,fma")
+#endif
+
+#include "DADAAUnits.hpp"
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+void DADAA::registerAVX512Units(InterfaceTable* inTable) { registerUnits(inTable); }
+
+#endif
@@ -0,0 +1,185 @@
+// Distortion.hpp
+// Rylee Alanza Lyman (ryleealanza@gmail.com)
+//
+// block processing shared by the DADAA UGens, the benchmarks and anything else
+// that wants to run the shapers outside of a server.
+
+#pragma once
+
+#include "Kernels.hpp"
+#include "Target.hpp"
+
+namespace DADAA {
+inline namespace DADAA_TARGET {
+
+// the highest order whose differences hold up in single precision.
+// above it, float's epsilon is too coarse for the higher differences not to blow up (see DADAABench).
+constexpr int kMaxSingleOrder = 1;
+
+// anti-aliased waveshaping with Shaper.
+// process<Order> runs ADAA of that order (0 to 4), which delays the wet signal by Order / 2 samples;
+// the dry signal is the input delayed by the whole part of that, so odd orders leave
+// the wet signal a further half sample behind it.
+// the order should stay the same from block to block.
+// with a null dry, only the wet signal is written and no input is kept for a dry one:
+// the wet signal only ever depends on the current and past inputs, so this form is causal,
+// with the group delay of Order / 2 samples its differences have, and no more.
+// the differences are computed in Real: float is faster, and accurate enough up to kMaxSingleOrder.
+template <class Shaper, class Real = double>
+class Distortion {
+public:
+  explicit Distortion(float gain = 0.f, const Shaper& shaper = Shaper()) :
+    mGain(gain), mDifference(shaper) {}
+
+  // gain at control or scalar rate: a change of gain is ramped linearly across the block,
+  // reaching the new value at the start of the next one
+  template <int Order>
+  void process(const float* input, float gain, float* wet, float* dry, int nSamples) {
+    if (gain == mGain) {
+      if (holdSettled<Order>(input, gain, wet, dry, nSamples)) {
+        return;
+      }
+      const double constant = gain;
+      run<Order>(input, [constant](int) { return constant; }, wet, dry, nSamples);
+    } else {
+      const double start = mGain;
+      const double slope = (static_cast<double>(gain) - start) / nSamples;
+      mGain = gain;
+      run<Order>(input, [start, slope](int i) { return start + slope * i; }, wet, dry, nSamples);
+    }
+  }
+
+  // gain at audio rate, one value per sample
+  template <int Order>
+  void process(const float* input, const float* gain, float* wet, float* dry, int nSamples) {
+    run<Order>(input, [gain](int i) { return static_cast<double>(gain[i]); }, wet, dry, nSamples);
+  }
+
+  // a single input, as at control rate, where every block is one sample long.
+  // the window and the dry signal's history are kept as process keeps them, but the gain takes effect at once,
+  // with no block to ramp it across. returns the wet sample, and writes the dry one to dry if it isn't null.
+  template <int Order>
+  float next(float input, float gain, float* dry) {
+    if (mOrder != Order) {
+      mOrder = Order;
+      mDifference.template prime<Order>();
+    }
+    mGain = gain;
+    const Real scaled = flushDenormal(static_cast<Real>(input * static_cast<double>(gain)));
+    float wet;
+    if (mDifference.settled(&scaled, 1)) {
+      countBranch(kSettled);
+      wet = static_cast<float>(mDifference.shaper().waveshape0(scaled));
+    } else {
+      countBranch(kSamples);
+      mDifference.template nextBlock<Order>(&scaled, &wet, 1);
+    }
+    if (dry != nullptr) {
+      constexpr int delay = Order / 2;
+      *dry = delay == 0 ? input : mInput[delay - 1];
+      mInput.push(input);
+    }
+    return wet;
+  }
+
+  // the delay of the wet signal at a given order, in samples
+  static constexpr double latency(int order) { return 0.5 * order; }
+
+private:
+  static constexpr int kChunk = 64;
+
+  // a block of one repeated input at a steady gain, once the window has settled on it, is one waveshape.
+  // this is checked on the raw input, before anything is scaled or copied, so silence and DC cost
+  // one pass over the block; it returns whether the block was written.
+  template <int Order>
+  bool holdSettled(const float* input, float gain, float* wet, float* dry, int nSamples) {
+    if (nSamples <= 0 || mOrder != Order) {
+      return false;
+    }
+    const float raw = input[0];
+    const Real x = flushDenormal(static_cast<Real>(raw * static_cast<double>(gain)));
+    if (!mDifference.settledOn(x)) {
+      return false;
+    }
+    // counted in a float, as in SlidingDifference::settled
+    float moved = 0.f;
+    for (int i = 0; i < nSamples; ++i) {
+      moved += input[i] == raw ? 0.f : 1.f;
+    }
+    if (moved != 0.f) {
+      return false;
+    }
+    countBranch(kSettled, nSamples);
+    const float held = static_cast<float>(mDifference.shaper().waveshape0(x));
+    for (int i = 0; i < nSamples; ++i) {
+      wet[i] = held;
+    }
+    if (dry != nullptr) {
+      constexpr int delay = Order / 2;
+      for (int i = 0; i < nSamples; ++i) {
+        dry[i] = i < delay ? mInput[delay - 1 - i] : raw;
+      }
+      for (int i = nSamples < 4 ? 0 : nSamples - 4; i < nSamples; ++i) {
+        mInput.push(raw);
+      }
+    }
+    return true;
+  }
+
+  // each input is scaled once, by gainAt(its index in the block), as it enters the window,
+  // so the window and its differences always hold gain-scaled values.
+  // once the window has settled on a constant input, the wet signal is just its waveshape.
+  template <int Order, class Gain>
+  void run(const float* input, Gain gainAt, float* wet, float* dry, int nSamples) {
+    if (mOrder != Order) {
+      // the table is kept for one order at a time
+      mOrder = Order;
+      mDifference.template prime<Order>();
+    }
+    // work from copies of the input, since the server may hand us an output buffer aliasing it
+    constexpr int delay = Order / 2;
+    for (int offset = 0; offset < nSamples; offset += kChunk) {
+      const int count = nSamples - offset < kChunk ? nSamples - offset : kChunk;
+      float raw[kChunk];
+      Real scaled[kChunk];
+      for (int i = 0; i < count; ++i) {
+        raw[i] = input[offset + i];
+        scaled[i] = flushDenormal(static_cast<Real>(raw[i] * gainAt(offset + i)));
+      }
+
+      if (mDifference.settled(scaled, count)) {
+        // constant input, e.g. silence or DC: skip the differences altogether
+        countBranch(kSettled, count);
+        const float held = static_cast<float>(mDifference.shaper().waveshape0(mDifference.window()[0]));
+        for (int i = 0; i < count; ++i) {
+          wet[offset + i] = held;
+        }
+      } else {
+        countBranch(kSamples, count);
+        mDifference.template nextBlock<Order>(scaled, wet + offset, count);
+      }
+
+      if (dry == nullptr) {
+        continue;
+      }
+      for (int i = 0; i < count; ++i) {
+        dry[offset + i] = i < delay ? mInput[delay - 1 - i] : raw[i - delay];
+      }
+      for (int i = count < 4 ? 0 : count - 4; i < count; ++i) {
+        mInput.push(raw[i]);
+      }
+    }
+  }
+
+  // the order the table was last primed for
+  int mOrder = 4;
+  // the control-rate gain at the end of the last block
+  float mGain;
+  // unscaled inputs, for the dry signal
+  History<> mInput;
+  // gain-scaled inputs and their differences
+  SlidingDifference<Shaper, Real> mDifference;
+};
+
+} // namespace DADAA_TARGET
+} // namespace DADAA
@@ -0,0 +1,795 @@
+// Kernels.hpp
+// Rylee Alanza Lyman (ryleealanza@gmail.com)
+//
+// the divided-difference machinery behind the DADAA UGens.
+// nothing in here depends on the SuperCollider plugin interface.
+
+#pragma once
+
+#include "BranchCounts.hpp"
+#include "Target.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+namespace DADAA {
+inline namespace DADAA_TARGET {
+
+// a Shaper is a type with members
+//   double waveshape0(double) ... double waveshape4(double),
+// the waveshaper and its first four anti-derivatives, and
+//   double eps,
+// how close two inputs may get before the differences switch to their fallbacks.
+// a fourth difference divides the rounding in the anti-derivatives by the fourth power of the gaps,
+// so this should be no smaller than about 0.001.
+// the differences below are templates over it, so that every shaper gets its own fully inlined kernel,
+// and take an instance of it, so that a shaper may carry data such as a table.
+// the fixed shapers make these static, and cost nothing to pass around.
+//
+// the differences are also templates over the type Real they compute in.
+// to run in single precision, a shaper's waveshapes must accept float,
+// and it needs a coarser epsilon, float epsFloat.
+//
+// a shaper that is made of polynomial pieces may also list them, as static Piecewise members (see Polynomial.hpp)
+//   kCurve, kW1, kW2, kW3, kW4,
+// the waveshaper and its anti-derivatives (see TanhShaper).
+// the blocks whose windows all lie in one piece then skip the quotients for a closed form.
+
+// the shaper's epsilon for differences computed in Real
+template <class Real, class Shaper>
+inline Real epsilon(const Shaper& shaper) {
+  if constexpr (std::is_same_v<Real, float>) {
+    return shaper.epsFloat;
+  } else {
+    return shaper.eps;
+  }
+}
+
+// the K-th anti-derivative of Shaper's waveshaper
+template <class Shaper, int K, class Real>
+inline Real waveshape(const Shaper& shaper, Real in) {
+  static_assert(K >= 0 && K <= 4, "shapers provide anti-derivatives up to the fourth");
+  if constexpr (K == 4) {
+    return shaper.waveshape4(in);
+  } else if constexpr (K == 3) {
+    return shaper.waveshape3(in);
+  } else if constexpr (K == 2) {
+    return shaper.waveshape2(in);
+  } else if constexpr (K == 1) {
+    return shaper.waveshape1(in);
+  } else {
+    return shaper.waveshape0(in);
+  }
+}
+
+// the anti-derivatives seen by a difference of order Top:
+// w4 is the Top-th anti-derivative, w3 the one below it and so on
+template <class Shaper, int Top, class Real = double>
+struct Antiderivatives {
+  const Shaper& shaper;
+
+  Real w4(Real in) const { return waveshape<Shaper, Top>(shaper, in); }
+  Real w3(Real in) const { return waveshape<Shaper, Top - 1>(shaper, in); }
+  Real w2(Real in) const { return waveshape<Shaper, Top - 2>(shaper, in); }
+  Real w1(Real in) const { return waveshape<Shaper, Top - 3>(shaper, in); }
+  Real w0(Real in) const { return waveshape<Shaper, Top - 4>(shaper, in); }
+};
+
+// the K-th anti-derivative of Shaper's waveshaper, for K chosen at run time, 0 <= K <= Top
+template <class Shaper, int Top, class Real>
+inline Real waveshapeAt(const Shaper& shaper, int k, Real in) {
+  if constexpr (Top > 0) {
+    if (k < Top) {
+      return waveshapeAt<Shaper, Top - 1>(shaper, k, in);
+    }
+  }
+  return waveshape<Shaper, Top>(shaper, in);
+}
+
+// K! times the divided difference of the Top-th anti-derivative over K + 1 nodes.
+// dClose below merges the inputs it finds close into one node, repeated:
+// a run of m equal nodes, which must sit next to each other, takes the derivatives there
+// up to the (m - 1)th, which are the anti-derivatives below the Top-th.
+template <class Shaper, int Top, class Real, int Nodes>
+inline Real confluentDifference(const Shaper& shaper, const Real (&nodes)[Nodes]) {
+  constexpr int K = Nodes - 1;
+  static_assert(K >= 1 && K <= Top, "the differences go up to the Top-th anti-derivative");
+  constexpr Real kFactorial[5] = {1, 1, 2, 6, 24};
+  // table[i] is the divided difference over nodes[i], ..., nodes[i + level]
+  Real table[Nodes];
+  // a repeated node's values are those of the entry before it
+  for (int i = 0; i < Nodes; ++i) {
+    table[i] = i > 0 && nodes[i] == nodes[i - 1] ? table[i - 1] : waveshape<Shaper, Top>(shaper, nodes[i]);
+  }
+  for (int level = 1; level <= K; ++level) {
+    for (int i = 0; i + level < Nodes; ++i) {
+      if (nodes[i + level] == nodes[i]) {
+        table[i] = i > 0 && nodes[i] == nodes[i - 1]
+          ? table[i - 1]
+          : waveshapeAt<Shaper, Top>(shaper, Top - level, nodes[i]) / kFactorial[level];
+      } else {
+        table[i] = (table[i + 1] - table[i]) / (nodes[i + level] - nodes[i]);
+      }
+    }
+  }
+  return kFactorial[K] * table[0];
+}
+
+// whether any two of in[0], ..., in[n - 1] are within eps of each other
+template <class Real>
+inline bool anyClose(const Real* in, int n, Real eps) {
+  bool close = false;
+  for (int i = 0; i < n; ++i) {
+    for (int j = i + 1; j < n; ++j) {
+      close = close || std::abs(in[i] - in[j]) <= eps;
+    }
+  }
+  return close;
+}
+template <class Real, int N>
+inline bool anyClose(const Real (&in)[N], Real eps) { return anyClose(static_cast<const Real*>(in), N, eps); }
+
+// how far apart neighbouring inputs may be, in multiples of epsilon, for dClose to merge them, by order.
+// a fourth difference over two runs just over eps apart would divide the rounding in the anti-derivatives
+// by the fourth power of the gap, which costs more than merging them does.
+constexpr double kMergeWidth[5] = {1., 1., 1., 1., 3.};
+
+// the fallback for a difference of order Nodes - 1 whose inputs are not all at least eps apart.
+// the inputs are sorted and each run of them whose neighbours are within kMergeWidth epsilons merged into its mean,
+// so that the quotients only ever divide by gaps wider than that.
+// merging errs by the square of the spread of a run, where the quotients would err
+// by the rounding in the anti-derivatives over a power of the gaps.
+template <class Shaper, int Top, class Real, int Nodes>
+inline Real dClose(const Shaper& shaper, const Real (&in)[Nodes], Real eps) {
+  constexpr int K = Nodes - 1;
+  constexpr Branch kSome[5] = {kD1Close, kD1Close, kD2Close, kD3Close, kD4Close};
+  constexpr Branch kAll[5] = {kD1Close, kD1Close, kD2CloseAll, kD3CloseAll, kD4CloseAll};
+  Real nodes[Nodes];
+  for (int i = 0; i < Nodes; ++i) {
+    int j = i;
+    for (; j > 0 && nodes[j - 1] > in[i]; --j) {
+      nodes[j] = nodes[j - 1];
+    }
+    nodes[j] = in[i];
+  }
+  const Real width = static_cast<Real>(kMergeWidth[K]) * eps;
+  int start = 0;
+  for (int i = 1; i <= Nodes; ++i) {
+    if (i < Nodes && nodes[i] - nodes[i - 1] <= width) {
+      continue;
+    }
+    Real sum = 0;
+    for (int j = start; j < i; ++j) {
+      sum += nodes[j];
+    }
+    const Real mean = sum / static_cast<Real>(i - start);
+    for (int j = start; j < i; ++j) {
+      nodes[j] = mean;
+    }
+    start = i;
+  }
+  if (nodes[0] == nodes[K]) {
+    // everything is close
+    countBranch(kAll[K]);
+    return waveshape<Shaper, Top - K>(shaper, nodes[0]);
+  }
+  countBranch(kSome[K]);
+  return confluentDifference<Shaper, Top>(shaper, nodes);
+}
+
+// the last few samples seen, indexed by age (0 is the newest)
+template <class Real = double>
+class History {
+public:
+  void push(Real in) {
+    mHead = (mHead + 1) & kMask;
+    mData[mHead] = in;
+  }
+  Real operator[](int age) const { return mData[(mHead - age) & kMask]; }
+  Real& operator[](int age) { return mData[(mHead - age) & kMask]; }
+
+private:
+  static constexpr unsigned kMask = 3;
+  Real mData[kMask + 1] = {};
+  unsigned mHead = 0;
+};
+
+// flushes values far below audibility to zero,
+// so that decaying inputs leave zeros in the history rather than denormals
+template <class Real>
+inline Real flushDenormal(Real x) { return std::abs(x) < Real(1e-15) ? Real(0) : x; }
+
+// whether Shaper lists its polynomial pieces
+template <class Shaper, class = void>
+struct HasPieces : std::false_type {};
+template <class Shaper>
+struct HasPieces<Shaper, std::void_t<decltype(Shaper::kW4)>> : std::true_type {};
+
+// the piece of Shaper that in falls in
+template <class Shaper, class Real>
+inline int pieceOf(Real in) { return Shaper::kCurve.piece(in); }
+
+// the pieces of Shaper's K-th anti-derivative
+template <class Shaper, int K>
+constexpr const auto& piecesOf() {
+  static_assert(K >= 1 && K <= 4, "the pieces are listed for the first to fourth anti-derivatives");
+  if constexpr (K == 1) {
+    return Shaper::kW1;
+  } else if constexpr (K == 2) {
+    return Shaper::kW2;
+  } else if constexpr (K == 3) {
+    return Shaper::kW3;
+  } else {
+    return Shaper::kW4;
+  }
+}
+
+// the piece that x[0], ..., x[n - 1] all fall in, or -1 if they straddle a break.
+// the pieces run in order along the line, so it is enough to find those of the least and the greatest.
+template <class Shaper, class Real>
+inline int commonPiece(const Real* x, int n) {
+  Real least = x[0];
+  Real greatest = x[0];
+  for (int i = 1; i < n; ++i) {
+    least = x[i] < least ? x[i] : least;
+    greatest = x[i] > greatest ? x[i] : greatest;
+  }
+  const int piece = pieceOf<Shaper>(least);
+  return pieceOf<Shaper>(greatest) == piece ? piece : -1;
+}
+
+// the piece that the newest ages inputs of window and in[0], ..., in[n - 1] all fall in,
+// or -1 if they straddle a break
+template <class Shaper, class Real>
+inline int commonPiece(const History<Real>& window, int ages, const Real* in, int n) {
+  const int piece = commonPiece<Shaper>(in, n);
+  for (int age = 0; age < ages && piece >= 0; ++age) {
+    if (pieceOf<Shaper>(window[age]) != piece) {
+      return -1;
+    }
+  }
+  return piece;
+}
+
+// the K-th difference, as d1 to d4 scale it (K! times the divided difference),
+// of the polynomial c[0] + c[1] t + ... + c[Degree] t^Degree over the points t[0], ..., t[K].
+// the divided difference of t^j is the complete homogeneous symmetric polynomial of degree j - K in the points,
+// found here from their power sums by Newton's identities:
+// no quotients of the inputs, so no epsilon tests, and no loss of accuracy as the points close up.
+template <int K, int Degree, class Real>
+inline Real pieceDifference(const double* c, const Real* t) {
+  constexpr Real kFactorial[5] = {1, 1, 2, 6, 24};
+  constexpr int N = Degree - K;
+  if constexpr (N < 0) {
+    return Real(0);
+  } else {
+    Real power[K + 1];
+    for (int a = 0; a <= K; ++a) {
+      power[a] = Real(1);
+    }
+    // powerSum[m] = sum of t[a]^m, complete[m] = the complete homogeneous polynomial of degree m
+    Real powerSum[N + 1];
+    Real complete[N + 1];
+    complete[0] = Real(1);
+    for (int m = 1; m <= N; ++m) {
+      powerSum[m] = Real(0);
+      for (int a = 0; a <= K; ++a) {
+        power[a] *= t[a];
+        powerSum[m] += power[a];
+      }
+      Real sum = Real(0);
+      for (int i = 1; i <= m; ++i) {
+        sum += powerSum[i] * complete[m - i];
+      }
+      complete[m] = sum * (Real(1) / Real(m));
+    }
+    Real out = Real(0);
+    for (int j = Degree; j >= K; --j) {
+      out += static_cast<Real>(c[j]) * complete[j - K];
+    }
+    return kFactorial[K] * out;
+  }
+}
+
+// the K-th difference of Shaper's Top-th anti-derivative over a window that lies in piece,
+// window(age) being its input age samples before the newest one
+template <class Shaper, int Top, int K, class Real, class Window>
+inline Real pieceDifferenceAt(int piece, Window window) {
+  const auto& pieces = piecesOf<Shaper, Top>();
+  const Real origin = static_cast<Real>(pieces.origins[piece]);
+  Real t[K + 1];
+  for (int age = 0; age <= K; ++age) {
+    t[age] = window(age) - origin;
+  }
+  return pieceDifference<K, std::decay_t<decltype(pieces)>::kDegree>(pieces.coefficients[piece], t);
+}
+
+// the K-th difference of Shaper's Top-th anti-derivative over in[0], ..., in[K], newest first, by its closed form,
+// if the shaper lists its pieces and the inputs all lie in one of them, as nextBlock takes it: sets out and returns true.
+// quotients over gaps just wider than epsilon would divide the rounding of the anti-derivatives by powers of them
+template <class Shaper, int Top, class Real, int Nodes>
+inline bool inOnePiece(const Real (&in)[Nodes], Real& out) {
+  if constexpr (HasPieces<Shaper>::value) {
+    const int piece = pieceOf<Shaper>(in[0]);
+    for (int i = 1; i < Nodes; ++i) {
+      if (pieceOf<Shaper>(in[i]) != piece) {
+        return false;
+      }
+    }
+    out = pieceDifferenceAt<Shaper, Top, Nodes - 1, Real>(piece, [&in](int age) { return in[age]; });
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// difference quotient
+template <class Shaper, int Top = 4, class Real>
+inline Real d1(const Shaper& shaper, Real in1, Real in2, Real mEps) {
+  const Antiderivatives<Shaper, Top, Real> W{shaper};
+  Real delta = in1 - in2;
+  if (std::abs(delta) > mEps) {
+    return (W.w4(in1) - W.w4(in2)) / delta;
+  } else {
+    countBranch(kD1Close);
+    return W.w3(0.5f * (in1 + in2));
+  }
+}
+// differential operator
+template <class Shaper, int Top = 4, class Real>
+inline Real d2(const Shaper& shaper, Real in1, Real in2, Real in3, Real mEps) {
+  Real out;
+  if (inOnePiece<Shaper, Top>({in1, in2, in3}, out)) {
+    return out;
+  }
+  if (anyClose({in1, in2, in3}, mEps)) {
+    return dClose<Shaper, Top>(shaper, {in1, in2, in3}, mEps);
+  }
+  Real delta = 1.f / (in1 - in3);
+  return 2.f * (d1<Shaper, Top>(shaper, in1, in2, mEps) - d1<Shaper, Top>(shaper, in2, in3, mEps)) * delta;
+}
+// differential operator
+template <class Shaper, int Top = 4, class Real>
+inline Real d3(const Shaper& shaper, Real in1, Real in2, Real in3, Real in4, Real mEps) {
+  Real out;
+  if (inOnePiece<Shaper, Top>({in1, in2, in3, in4}, out)) {
+    return out;
+  }
+  if (anyClose({in1, in2, in3, in4}, mEps)) {
+    return dClose<Shaper, Top>(shaper, {in1, in2, in3, in4}, mEps);
+  }
+  Real delta = in1 - in4;
+  return 3.f * (d2<Shaper, Top>(shaper, in1, in2, in3, mEps) - d2<Shaper, Top>(shaper, in2, in3, in4, mEps)) / delta;
+}
+// differential operator
+template <class Shaper, int Top = 4, class Real>
+inline Real d4(const Shaper& shaper, Real in1, Real in2, Real in3, Real in4, Real in5,
+                 Real mEps) {
+  Real out;
+  if (inOnePiece<Shaper, Top>({in1, in2, in3, in4, in5}, out)) {
+    return out;
+  }
+  if (anyClose({in1, in2, in3, in4, in5}, mEps)) {
+    return dClose<Shaper, Top>(shaper, {in1, in2, in3, in4, in5}, mEps);
+  }
+  return 4.f * (d3<Shaper, Top>(shaper, in1, in2, in3, in4, mEps) - d3<Shaper, Top>(shaper, in2, in3, in4, in5, mEps)) / (in1 - in5);
+}
+
+// the Order-th differences of the n windows ending at x[4], ..., x[n + 3] (n at most Capacity),
+// which all lie in piece, by their closed forms:
+// the same arithmetic as pieceDifference, with the power sums taken a power at a time over every window
+// so that it runs in vector lanes.
+template <class Shaper, int Order, int Capacity, class Real>
+inline void pieceLanes(int piece, const Real* x, Real* diff, int n) {
+  constexpr Real kFactorial[5] = {1, 1, 2, 6, 24};
+  const auto& pieces = piecesOf<Shaper, Order>();
+  constexpr int kDegree = std::decay_t<decltype(pieces)>::kDegree;
+  constexpr int N = kDegree - Order;
+  const double* c = pieces.coefficients[piece];
+  // the pieces share a degree, so some end in zeros.
+  // those of degree Order, e.g. where tanh has flattened out, have constant differences.
+  bool flat = true;
+  for (int j = Order + 1; j <= kDegree; ++j) {
+    flat = flat && c[j] == 0;
+  }
+  if (flat) {
+    const Real constant = kFactorial[Order] * static_cast<Real>(c[Order]);
+    for (int i = 0; i < n; ++i) {
+      diff[i] = constant;
+    }
+    return;
+  }
+  // powerSum[m][i] is the sum of the m-th powers over the window ending at x[i + 4], less the origin
+  const Real origin = static_cast<Real>(pieces.origins[piece]);
+  Real t[Capacity + 4];
+  Real power[Capacity + 4];
+  Real powerSum[N + 1][Capacity];
+  for (int i = 0; i < n + 4; ++i) {
+    t[i] = x[i] - origin;
+    power[i] = Real(1);
+  }
+  for (int m = 1; m <= N; ++m) {
+    for (int i = 0; i < n + 4; ++i) {
+      power[i] *= t[i];
+    }
+    for (int i = 0; i < n; ++i) {
+      Real sum = Real(0);
+      for (int age = 0; age <= Order; ++age) {
+        sum += power[i + 4 - age];
+      }
+      powerSum[m][i] = sum;
+    }
+  }
+  for (int i = 0; i < n; ++i) {
+    Real complete[N + 1];
+    complete[0] = Real(1);
+    for (int m = 1; m <= N; ++m) {
+      Real sum = Real(0);
+      for (int k = 1; k <= m; ++k) {
+        sum += powerSum[k][i] * complete[m - k];
+      }
+      complete[m] = sum * (Real(1) / Real(m));
+    }
+    Real out = Real(0);
+    for (int j = kDegree; j >= Order; --j) {
+      out += static_cast<Real>(c[j]) * complete[j - Order];
+    }
+    diff[i] = kFactorial[Order] * out;
+  }
+}
+
+// the K-th difference quotients of n windows at once, from the (K - 1)-th ones:
+// lowerNew[i] ends at the newest input of window i and lowerOld[i] at the one before it.
+// window(i, age) is the input age samples before the newest one of window i.
+// close[i] is set to 1 if window i has two inputs within epsilon, which is so if either of its lower windows has
+// (closeNew[i] or closeOld[i], unused for K == 1) or its ends are.
+// the quotients are computed in every lane and, for K == Order, the close lanes patched afterwards,
+// with the same arithmetic as SlidingDifference::next<Order>, so the results agree exactly.
+// below Order there is no need: a close window's difference only goes into the higher differences
+// over windows that contain it, which are close too and fall back without it.
+template <class Shaper, int Order, int K, class Real, class Window>
+inline void quotientLanes(const Shaper& shaper, const Real* lowerNew, const Real* lowerOld, const Real* closeNew,
+                          const Real* closeOld, Real* diff, Real* close, int n, Window window) {
+  const Antiderivatives<Shaper, Order, Real> W{shaper};
+  const Real eps = epsilon<Real>(shaper);
+  // counted in a Real so that the loop keeps a single lane width
+  Real fallbacks = 0;
+  for (int i = 0; i < n; ++i) {
+    const Real delta = window(i, 0) - window(i, K);
+    Real near = std::abs(delta) > eps ? Real(0) : Real(1);
+    if constexpr (K > 1) {
+      near = std::max(near, std::max(closeNew[i], closeOld[i]));
+    }
+    close[i] = near;
+    fallbacks += near;
+    if constexpr (K == 1) {
+      diff[i] = (lowerNew[i] - lowerOld[i]) / delta;
+    } else if constexpr (K == 2) {
+      diff[i] = 2.f * (lowerNew[i] - lowerOld[i]) * (1.f / delta);
+    } else if constexpr (K == 3) {
+      diff[i] = 3.f * (lowerNew[i] - lowerOld[i]) / delta;
+    } else {
+      diff[i] = 4.f * (lowerNew[i] - lowerOld[i]) / delta;
+    }
+  }
+  if (fallbacks == 0 || K < Order) {
+    return;
+  }
+  for (int i = 0; i < n; ++i) {
+    if (close[i] == 0) {
+      continue;
+    }
+    if constexpr (K == 1) {
+      countBranch(kD1Close);
+      diff[i] = W.w3(0.5f * (window(i, 0) + window(i, 1)));
+    } else if constexpr (K == 2) {
+      diff[i] = dClose<Shaper, Order>(shaper, {window(i, 0), window(i, 1), window(i, 2)}, eps);
+    } else if constexpr (K == 3) {
+      diff[i] = dClose<Shaper, Order>(shaper, {window(i, 0), window(i, 1), window(i, 2), window(i, 3)}, eps);
+    } else {
+      diff[i] = dClose<Shaper, Order>(shaper, {window(i, 0), window(i, 1), window(i, 2), window(i, 3), window(i, 4)}, eps);
+    }
+  }
+}
+
+// streaming divided differences.
+// keeps the window of the last four inputs together with the top anti-derivative of the newest one
+// and the lower-order differences ending at it,
+// so that each new sample costs one evaluation of the top anti-derivative plus one difference per order.
+// the fallbacks are only evaluated when their epsilon tests fire.
+// the order (0 to 4) is chosen per call; a difference of order N uses the N-th anti-derivative
+// and is centred N / 2 samples behind the newest input.
+template <class Shaper, class Real = double>
+class SlidingDifference {
+public:
+  explicit SlidingDifference(const Shaper& shaper = Shaper()) : mShaper(shaper) { prime<4>(); }
+
+  // rebuild the table for differences of order Order from the current window,
+  // e.g. after writing to the window
+  template <int Order>
+  void prime() {
+    if constexpr (Order > 0) {
+      mTop = waveshape<Shaper, Order>(mShaper, mWindow[0]);
+    }
+    if constexpr (Order > 1) {
+      mDiff1 = d1<Shaper, Order>(mShaper, mWindow[0], mWindow[1], epsilon<Real>(mShaper));
+    }
+    if constexpr (Order > 2) {
+      mDiff2 = d2<Shaper, Order>(mShaper, mWindow[0], mWindow[1], mWindow[2], epsilon<Real>(mShaper));
+    }
+    if constexpr (Order > 3) {
+      mDiff3 = d3<Shaper, Order>(mShaper, mWindow[0], mWindow[1], mWindow[2], mWindow[3], epsilon<Real>(mShaper));
+    }
+  }
+
+  // push a new input and return the difference of order Order over the window ending at it.
+  // this gives the same result as nextBlock<Order> on the one input, and for Order == 4 the same as
+  // d4<Shaper>(shaper, in, window[0], window[1], window[2], window[3]) up to rounding,
+  // provided the table was last primed or advanced at the same order.
+  template <int Order>
+  Real next(Real in) {
+    static_assert(Order >= 0 && Order <= 4, "differences go up to the fourth order");
+    if constexpr (Order > 0 && HasPieces<Shaper>::value) {
+      const int piece = commonPiece<Shaper>(mWindow, Order, &in, 1);
+      if (piece >= 0) {
+        Real out;
+        chunkInPiece<Order>(&in, piece, &out, 1);
+        return out;
+      }
+    }
+    const Antiderivatives<Shaper, Order, Real> W{mShaper};
+    const Real in2 = mWindow[0];
+    const Real in3 = mWindow[1];
+    const Real in4 = mWindow[2];
+    const Real in5 = mWindow[3];
+    mWindow.push(in);
+
+    if constexpr (Order == 0) {
+      return mShaper.waveshape0(in);
+    } else {
+      const Real top = W.w4(in);
+      const Real eps = epsilon<Real>(mShaper);
+      // as in quotientLanes, the fallbacks are only needed at the order asked for
+      Real delta = in - in2;
+      Real diff1;
+      if (Order > 1 || std::abs(delta) > eps) {
+        diff1 = (top - mTop) / delta;
+      } else {
+        countBranch(kD1Close);
+        diff1 = W.w3(0.5f * (in + in2));
+      }
+      mTop = top;
+      if constexpr (Order == 1) {
+        return diff1;
+      } else {
+        Real diff2;
+        if (Order > 2 || !anyClose({in, in2, in3}, eps)) {
+          delta = 1.f / (in - in3);
+          diff2 = 2.f * (diff1 - mDiff1) * delta;
+        } else {
+          diff2 = dClose<Shaper, Order>(mShaper, {in, in2, in3}, eps);
+        }
+        mDiff1 = diff1;
+        if constexpr (Order == 2) {
+          return diff2;
+        } else {
+          Real diff3;
+          if (Order > 3 || !anyClose({in, in2, in3, in4}, eps)) {
+            delta = in - in4;
+            diff3 = 3.f * (diff2 - mDiff2) / delta;
+          } else {
+            diff3 = dClose<Shaper, Order>(mShaper, {in, in2, in3, in4}, eps);
+          }
+          mDiff2 = diff2;
+          if constexpr (Order == 3) {
+            return diff3;
+          } else {
+            Real diff4;
+            if (!anyClose({in, in2, in3, in4, in5}, eps)) {
+              diff4 = 4.f * (diff3 - mDiff3) / (in - in5);
+            } else {
+              diff4 = dClose<Shaper, Order>(mShaper, {in, in2, in3, in4, in5}, eps);
+            }
+            mDiff3 = diff3;
+            return diff4;
+          }
+        }
+      }
+    }
+  }
+
+  // the same as out[i] = next<Order>(in[i]) for i in [0, n), one order at a time:
+  // each pass computes the difference quotients of a whole chunk in vector lanes,
+  // and only the lanes whose epsilon tests fired are sent through the scalar fallbacks.
+  // if the shaper lists its pieces, the spans of kSpan samples whose windows all lie in one piece
+  // take their closed form instead,
+  // which agrees with the quotients up to rounding where they are well-conditioned, and is better where they are not.
+  template <int Order, class Out>
+  void nextBlock(const Real* in, Out* out, int n) {
+    for (int offset = 0; offset < n; offset += kChunk) {
+      const int count = n - offset < kChunk ? n - offset : kChunk;
+      if constexpr (Order > 0 && HasPieces<Shaper>::value) {
+        nextSplit<Order>(in + offset, out + offset, count);
+      } else {
+        nextChunk<Order>(in + offset, out + offset, count);
+      }
+    }
+  }
+
+  // the window, newest input first
+  History<Real>& window() { return mWindow; }
+
+  const Shaper& shaper() const { return mShaper; }
+
+  // whether the window and in[0], ..., in[n - 1] all hold the same value.
+  // if so, the table only depends on that value, so pushing in would leave it as it is,
+  // and the differences of every order can be taken to be waveshape0 of it.
+  // the value is taken from the window, so nothing is read from in past n.
+  bool settled(const Real* in, int n) const {
+    const Real x = mWindow[0];
+    if (n <= 0 || !settledOn(x)) {
+      return false;
+    }
+    // counted in a Real, as in quotientLanes
+    Real moved = 0;
+    for (int i = 0; i < n; ++i) {
+      moved += in[i] == x ? Real(0) : Real(1);
+    }
+    return moved == 0;
+  }
+
+  // whether the window holds x and nothing else
+  bool settledOn(Real x) const {
+    return mWindow[0] == x && mWindow[1] == x && mWindow[2] == x && mWindow[3] == x;
+  }
+
+private:
+  static constexpr int kChunk = 64;
+  // the samples nextBlock tests for lying in one piece at a time
+  static constexpr int kSpan = 16;
+
+  template <int Order, class Out>
+  void nextChunk(const Real* in, Out* out, int n) {
+    static_assert(Order >= 0 && Order <= 4, "differences go up to the fourth order");
+    if constexpr (Order == 0) {
+      for (int i = 0; i < n; ++i) {
+        out[i] = static_cast<Out>(mShaper.waveshape0(in[i]));
+      }
+    } else {
+      const Antiderivatives<Shaper, Order, Real> W{mShaper};
+      // x[i + 4] is in[i], preceded by the window.
+      // in the tables, entry i + 1 ends at in[i] and entry 0 is the stored one.
+      Real x[kChunk + 4];
+      Real top[kChunk + 1];
+      Real diffs[Order][kChunk + 1] = {};
+      for (int age = 0; age < 4; ++age) {
+        x[3 - age] = mWindow[age];
+      }
+      for (int i = 0; i < n; ++i) {
+        x[i + 4] = in[i];
+      }
+      auto window = [&x](int i, int age) { return x[i + 4 - age]; };
+
+      top[0] = mTop;
+      for (int i = 0; i < n; ++i) {
+        top[i + 1] = W.w4(x[i + 4]);
+      }
+      // whether each window has two inputs within epsilon, in the same layout,
+      // with the stored entries worked out afresh from the window
+      Real close[Order][kChunk + 1] = {};
+      for (int k = 1; k < Order; ++k) {
+        close[k - 1][0] = anyClose(x + 3 - k, k + 1, epsilon<Real>(mShaper)) ? Real(1) : Real(0);
+      }
+      const Real* none = nullptr;
+      quotientLanes<Shaper, Order, 1>(mShaper, top + 1, top, none, none, diffs[0] + 1, close[0] + 1, n, window);
+      if constexpr (Order > 1) {
+        diffs[0][0] = mDiff1;
+        quotientLanes<Shaper, Order, 2>(mShaper, diffs[0] + 1, diffs[0], close[0] + 1, close[0], diffs[1] + 1,
+                                        close[1] + 1, n, window);
+      }
+      if constexpr (Order > 2) {
+        diffs[1][0] = mDiff2;
+        quotientLanes<Shaper, Order, 3>(mShaper, diffs[1] + 1, diffs[1], close[1] + 1, close[1], diffs[2] + 1,
+                                        close[2] + 1, n, window);
+      }
+      if constexpr (Order > 3) {
+        diffs[2][0] = mDiff3;
+        quotientLanes<Shaper, Order, 4>(mShaper, diffs[2] + 1, diffs[2], close[2] + 1, close[2], diffs[3] + 1,
+                                        close[3] + 1, n, window);
+      }
+
+      for (int i = 0; i < n; ++i) {
+        out[i] = static_cast<Out>(diffs[Order - 1][i + 1]);
+      }
+      mTop = top[n];
+      if constexpr (Order > 1) {
+        mDiff1 = diffs[0][n];
+      }
+      if constexpr (Order > 2) {
+        mDiff2 = diffs[1][n];
+      }
+      if constexpr (Order > 3) {
+        mDiff3 = diffs[2][n];
+      }
+    }
+    for (int i = n < 4 ? 0 : n - 4; i < n; ++i) {
+      mWindow.push(in[i]);
+    }
+  }
+
+  // nextChunk for a chunk tested kSpan samples at a time:
+  // the spans whose windows all lie in one piece take their closed forms, the rest the quotients,
+  // with neighbouring spans that go the same way run together, so a chunk in one piece is one run
+  template <int Order, class Out>
+  void nextSplit(const Real* in, Out* out, int n) {
+    // the piece of each span, or -1 if one of its windows straddles a break
+    int pieces[kChunk / kSpan];
+    const int spans = (n + kSpan - 1) / kSpan;
+    pieces[0] = commonPiece<Shaper>(mWindow, Order, in, n < kSpan ? n : kSpan);
+    for (int span = 1; span < spans; ++span) {
+      const int start = span * kSpan;
+      const int end = start + kSpan < n ? start + kSpan : n;
+      pieces[span] = commonPiece<Shaper>(in + start - Order, end - start + Order);
+    }
+    for (int span = 0; span < spans;) {
+      int next = span + 1;
+      while (next < spans && pieces[next] == pieces[span]) {
+        ++next;
+      }
+      const int start = span * kSpan;
+      const int end = next * kSpan < n ? next * kSpan : n;
+      if (pieces[span] >= 0) {
+        chunkInPiece<Order>(in + start, pieces[span], out + start, end - start);
+      } else {
+        nextChunk<Order>(in + start, out + start, end - start);
+      }
+      span = next;
+    }
+  }
+
+  // nextChunk for a chunk whose windows all lie in piece, by their closed forms.
+  // the table is left as the quotients would leave it: the top anti-derivative of the newest input,
+  // and the lower differences ending at it.
+  template <int Order, class Out>
+  void chunkInPiece(const Real* in, int piece, Out* out, int n) {
+    countBranch(kInPiece, n);
+    // x[i + 4] is in[i], preceded by the window
+    Real x[kChunk + 4];
+    Real diff[kChunk];
+    for (int age = 0; age < 4; ++age) {
+      x[3 - age] = mWindow[age];
+    }
+    for (int i = 0; i < n; ++i) {
+      x[i + 4] = in[i];
+    }
+    pieceLanes<Shaper, Order, kChunk>(piece, x, diff, n);
+    for (int i = 0; i < n; ++i) {
+      out[i] = static_cast<Out>(diff[i]);
+    }
+    for (int i = n < 4 ? 0 : n - 4; i < n; ++i) {
+      mWindow.push(in[i]);
+    }
+    auto newest = [this](int age) { return mWindow[age]; };
+    mTop = waveshape<Shaper, Order>(mShaper, newest(0));
+    if constexpr (Order > 1) {
+      mDiff1 = pieceDifferenceAt<Shaper, Order, 1, Real>(piece, newest);
+    }
+    if constexpr (Order > 2) {
+      mDiff2 = pieceDifferenceAt<Shaper, Order, 2, Real>(piece, newest);
+    }
+    if constexpr (Order > 3) {
+      mDiff3 = pieceDifferenceAt<Shaper, Order, 3, Real>(piece, newest);
+    }
+  }
+
+  Shaper mShaper;
+  History<Real> mWindow;
+  Real mTop;
+  Real mDiff1;
+  Real mDiff2;
+  Real mDiff3;
+};
+
+} // namespace DADAA_TARGET
+} // namespace DADAA
@@ -0,0 +1,255 @@
+// Oversampler.hpp
+// Rylee Alanza Lyman (ryleealanza@gmail.com)
+//
+// polyphase halfband filters, for running a shaper at twice or four times the sample rate.
+// a halfband lowpass has every other tap zero but the centre one, which is a half,
+// so both doubling and halving the rate come down to interpolating midpoints between samples.
+
+#pragma once
+
+#include "Distortion.hpp"
+#include "Target.hpp"
+
+namespace DADAA {
+inline namespace DADAA_TARGET {
+
+// a halfband lowpass, by the weights it gives to the samples either side of a midpoint:
+// the two j + 1/2 samples away from it get weights[j] each, and the weights add up to a half.
+template <int Taps>
+struct Halfband {
+  static constexpr int kTaps = Taps;
+  float weights[Taps];
+};
+
+// Kaiser-windowed sinc (beta 8.4). at 48 kHz, it passes up to 20 kHz
+// and stops from 28 kHz, both to within about 83 dB.
+constexpr Halfband<16> kFirstStage = {{
+  0.63418749637631255f, -0.20497119420418675f, 0.11558153518174064f, -0.075153176235064872f,
+  0.051481556198890027f, -0.035836501965534527f, 0.024867605434495309f, -0.016986804908038416f,
+  0.011309266931304412f, -0.0072698065160668353f, 0.0044655380962435468f, -0.0025869868937648832f,
+  0.0013872077030417285f, -0.00066777175697564975f, 0.00027187062937199556f, -7.98340717681827e-05f,
+}};
+
+// the second stage, between twice and four times the rate, only has to keep the band the first passed,
+// which leaves it a wide transition: Kaiser-windowed sinc (beta 9.4), also to within about 83 dB.
+constexpr Halfband<5> kSecondStage = {{
+  0.60892689799827515f, -0.1410267750724076f, 0.038927456740522871f, -0.007372794569568541f,
+  0.00054521490317813062f,
+}};
+
+// mid[i] = the midpoint of x[i + Taps - 1] and x[i + Taps], for i in [0, n),
+// interpolated from x[i], ..., x[i + 2 * Taps - 1].
+// one pass per tap over the whole block, so that the passes run in vector lanes.
+template <int Taps>
+inline void halfbandMidpoints(const Halfband<Taps>& filter, const float* x, float* mid, int n) {
+  for (int i = 0; i < n; ++i) {
+    mid[i] = 0.f;
+  }
+  for (int j = 0; j < Taps; ++j) {
+    const float weight = filter.weights[j];
+    const float* before = x + Taps - 1 - j;
+    const float* after = x + Taps + j;
+    for (int i = 0; i < n; ++i) {
+      mid[i] += weight * (before[i] + after[i]);
+    }
+  }
+}
+
+// doubles the rate of a signal: each input is followed by the midpoint between it and the next.
+// the output is the input Taps samples late.
+template <int Taps>
+class Upsampler {
+public:
+  // the most inputs a call takes
+  static constexpr int kMaxBlock = 128;
+
+  explicit Upsampler(const Halfband<Taps>& filter) : mFilter(filter) {}
+
+  // n inputs in, 2 * n outputs out
+  void process(const float* in, float* out, int n) {
+    // x[i + kHistory] is in[i], preceded by the last inputs of the previous call
+    float x[kHistory + kMaxBlock];
+    float mid[kMaxBlock];
+    for (int i = 0; i < kHistory; ++i) {
+      x[i] = mHistory[i];
+    }
+    for (int i = 0; i < n; ++i) {
+      x[kHistory + i] = in[i];
+    }
+    halfbandMidpoints(mFilter, x + 1, mid, n);
+    for (int i = 0; i < n; ++i) {
+      out[2 * i] = x[i + Taps];
+      out[2 * i + 1] = mid[i];
+    }
+    for (int i = 0; i < kHistory; ++i) {
+      mHistory[i] = x[n + i];
+    }
+  }
+
+private:
+  static constexpr int kHistory = 2 * Taps;
+
+  Halfband<Taps> mFilter;
+  float mHistory[kHistory] = {};
+};
+
+// halves the rate of a signal: it is lowpassed by the halfband, and every other sample kept.
+// the output is the input Taps (output) samples late.
+template <int Taps>
+class Downsampler {
+public:
+  // the most outputs a call gives
+  static constexpr int kMaxBlock = 128;
+
+  explicit Downsampler(const Halfband<Taps>& filter) : mFilter(filter) {}
+
+  // 2 * n inputs in, n outputs out
+  void process(const float* in, float* out, int n) {
+    // the input split into its even and odd samples, each preceded by those of the previous call.
+    // output i is centred on even[i + Taps], between odd[i + Taps - 1] and odd[i + Taps].
+    float even[kHistory + kMaxBlock];
+    float odd[kHistory + kMaxBlock];
+    float mid[kMaxBlock];
+    for (int i = 0; i < kHistory; ++i) {
+      even[i] = mEven[i];
+      odd[i] = mOdd[i];
+    }
+    for (int i = 0; i < n; ++i) {
+      even[kHistory + i] = in[2 * i];
+      odd[kHistory + i] = in[2 * i + 1];
+    }
+    halfbandMidpoints(mFilter, odd, mid, n);
+    for (int i = 0; i < n; ++i) {
+      out[i] = 0.5f * (even[i + Taps] + mid[i]);
+    }
+    for (int i = 0; i < kHistory; ++i) {
+      mEven[i] = even[n + i];
+      mOdd[i] = odd[n + i];
+    }
+  }
+
+private:
+  static constexpr int kHistory = 2 * Taps;
+
+  Halfband<Taps> mFilter;
+  float mEven[kHistory] = {};
+  float mOdd[kHistory] = {};
+};
+
+// Distortion run at 1, 2 or 4 times the sample rate, so that a low order of ADAA
+// and the oversampling share the anti-aliasing between them.
+// the gain is applied before upsampling, the shaper runs at the higher rate with gain 1,
+// and the filters add latency(order, factor) samples of delay to the wet signal.
+// the dry signal is the input delayed by the whole part of that, and is skipped for a null dry.
+// the factor is fixed when it is made; with a factor of 1, it is just a Distortion.
+template <class Shaper, class Real = double>
+class OversampledDistortion {
+public:
+  explicit OversampledDistortion(float gain = 0.f, int factor = 1, const Shaper& shaper = Shaper()) :
+    mFactor(factor < 2 ? 1 : factor < 4 ? 2 : 4), mGain(gain), mDistortion(gain, shaper),
+    mInner(1.f, shaper) {}
+
+  int factor() const { return mFactor; }
+
+  // gain at control or scalar rate, ramped across the block as Distortion does
+  template <int Order>
+  void process(const float* input, float gain, float* wet, float* dry, int nSamples) {
+    if (mFactor == 1) {
+      mDistortion.template process<Order>(input, gain, wet, dry, nSamples);
+    } else if (gain == mGain) {
+      run<Order>(input, [gain](int) { return gain; }, wet, dry, nSamples);
+    } else {
+      const float start = mGain;
+      const float slope = (gain - start) / nSamples;
+      mGain = gain;
+      run<Order>(input, [start, slope](int i) { return start + slope * i; }, wet, dry, nSamples);
+    }
+  }
+
+  // gain at audio rate, one value per sample
+  template <int Order>
+  void process(const float* input, const float* gain, float* wet, float* dry, int nSamples) {
+    if (mFactor == 1) {
+      mDistortion.template process<Order>(input, gain, wet, dry, nSamples);
+    } else {
+      run<Order>(input, [gain](int i) { return gain[i]; }, wet, dry, nSamples);
+    }
+  }
+
+  // a single input, as Distortion::next; only without oversampling, as at control rate
+  template <int Order>
+  float next(float input, float gain, float* dry) {
+    return mDistortion.template next<Order>(input, gain, dry);
+  }
+
+  // the delay of the wet signal at a given order and factor, in samples:
+  // each halfband delays by its length, and the shaper by half its order at the higher rate
+  static constexpr double latency(int order, int factor) {
+    if (factor < 2) {
+      return Distortion<Shaper, Real>::latency(order);
+    }
+    const int filters = 2 * kFirstStage.kTaps + (factor < 4 ? 0 : kSecondStage.kTaps);
+    return filters + Distortion<Shaper, Real>::latency(order) / (factor < 4 ? 2 : 4);
+  }
+
+private:
+  // base-rate samples per pass, so that four times as many fit the filters' blocks
+  static constexpr int kChunk = 32;
+  static constexpr int kDryCapacity = 64;
+
+  template <int Order, class Gain>
+  void run(const float* input, Gain gainAt, float* wet, float* dry, int nSamples) {
+    const int delay = static_cast<int>(latency(Order, mFactor));
+    for (int offset = 0; offset < nSamples; offset += kChunk) {
+      const int count = nSamples - offset < kChunk ? nSamples - offset : kChunk;
+      const int high = count * mFactor;
+      float raw[kChunk];
+      float scaled[kChunk];
+      for (int i = 0; i < count; ++i) {
+        raw[i] = input[offset + i];
+        scaled[i] = raw[i] * gainAt(offset + i);
+      }
+
+      float twice[2 * kChunk];
+      float fast[4 * kChunk];
+      float shaped[4 * kChunk];
+      mUpFirst.process(scaled, twice, count);
+      if (mFactor == 4) {
+        mUpSecond.process(twice, fast, 2 * count);
+        mInner.template process<Order>(fast, 1.f, shaped, nullptr, high);
+        mDownSecond.process(shaped, twice, 2 * count);
+        mDownFirst.process(twice, wet + offset, count);
+      } else {
+        mInner.template process<Order>(twice, 1.f, shaped, nullptr, high);
+        mDownFirst.process(shaped, wet + offset, count);
+      }
+
+      if (dry == nullptr) {
+        continue;
+      }
+      for (int i = 0; i < count; ++i) {
+        mDry[mDryWrite] = raw[i];
+        dry[offset + i] = mDry[(mDryWrite - delay) & (kDryCapacity - 1)];
+        mDryWrite = (mDryWrite + 1) & (kDryCapacity - 1);
+      }
+    }
+  }
+
+  int mFactor;
+  // the control-rate gain at the end of the last block
+  float mGain;
+  // the whole unit, when there is no oversampling
+  Distortion<Shaper, Real> mDistortion;
+  // the shaper at the higher rate
+  Distortion<Shaper, Real> mInner;
+  Upsampler<16> mUpFirst{kFirstStage};
+  Upsampler<5> mUpSecond{kSecondStage};
+  Downsampler<5> mDownSecond{kSecondStage};
+  Downsampler<16> mDownFirst{kFirstStage};
+  // unscaled inputs, for the dry signal
+  float mDry[kDryCapacity] = {};
+  int mDryWrite = 0;
+};
+
+} // namespace DADAA_TARGET
+} // namespace DADAA
@@ -0,0 +1,187 @@
+// Polylog.hpp
+// Rylee Alanza Lyman (ryleealanza@gmail.com)
+//
+// tanh and its first four anti-derivatives, exactly rather than by polynomial pieces.
+// past the first, log cosh x, these take polylogarithms: with u = e^{-2|x|},
+//   log cosh x = |x| - log 2 - Li1(-u),
+// and each further anti-derivative is a polynomial in |x| plus the next Li_K(-u), up to Li4.
+// near 0, u is close to 1 and the polylogarithms converge slowly, so there log cosh is a polynomial
+// in x^2 instead, integrated exactly into the others.
+// everything is polynomials, selects and bit twiddling, with no calls into libm and no branches,
+// so that loops over these vectorize. each function is accurate to within a few units in the last place.
+
+#pragma once
+
+#include "Polynomial.hpp"
+#include "Target.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace DADAA {
+inline namespace DADAA_TARGET {
+
+namespace polylog {
+
+// the polynomial for log cosh stops at |x| = kNear, where the polylogarithms take over (u <= kFarU)
+constexpr double kNear = 0.75;
+constexpr double kFarU = 0.22313016014842982;
+
+constexpr double kLn2 = 0.69314718055994531;
+constexpr double kPiSquared = 9.8696044010893586;
+constexpr double kPiFourth = 97.409091034002437;
+constexpr double kZeta3 = 1.2020569031595943;
+
+// e^r for |r| <= log(2) / 2, minimax (by Chebyshev interpolation), relative error below 2e-17
+constexpr double kExp[12] = {
+  1.0, 1.0, 0.5000000000000019, 0.1666666666666668, 0.0416666666664881, 0.008333333333319601,
+  0.0013888888952314775, 0.00019841269890047113, 2.4801485482328494e-05, 2.755724091857897e-06,
+  2.763263963904103e-07, 2.5110037605963777e-08,
+};
+
+// log cosh x / x^2 as a polynomial in x^2, for |x| <= kNear, error below 3e-18
+constexpr int kLogCoshDegree = 12;
+constexpr double kLogCosh[kLogCoshDegree + 1] = {
+  0.5, -0.08333333333333269, 0.02222222222215754, -0.0067460317434871325, 0.0021869488014526445,
+  -0.0007386023221838909, 0.00025657553171000224, -9.096279781304856e-05, 3.268047270322507e-05,
+  -1.1702763976921858e-05, 3.953222593287847e-06, -1.0877301036102407e-06, 1.712980917330056e-07,
+};
+
+// Li_K(-u) / u as polynomials in u, for 0 <= u <= kFarU, error below 2e-17
+constexpr double kLi1[13] = {
+  -1.0, 0.4999999999999969, -0.3333333333325465, 0.24999999992197575, -0.19999999596864007,
+  0.16666654227418368, -0.1428546678924628, 0.12496679226528325, -0.11080322053898554,
+  0.09800980970852732, -0.08198527301024584, 0.05609817180850485, -0.022069540812826555,
+};
+constexpr double kLi2[12] = {
+  -1.0, 0.24999999999999525, -0.11111111111009388, 0.0624999999143709, -0.03999999626388991,
+  0.027777681197808646, -0.020406571523968915, 0.015607585557354335, -0.012216879605077472,
+  0.009356025195463386, -0.006127071671222421, 0.0024058589389738135,
+};
+constexpr double kLi3[12] = {
+  -1.0, 0.12499999999999961, -0.03703703703695277, 0.015624999992909746, -0.007999999690866203,
+  0.004629621646758592, -0.0029153205250763647, 0.0019516908344795875, -0.0013611686880105034,
+  0.0009473989579452619, -0.0005782099589281152, 0.00021704847369332685,
+};
+constexpr double kLi4[11] = {
+  -1.0, 0.06249999999999926, -0.012345679012212403, 0.0039062499906241228, -0.0015999996605686058,
+  0.0007715977371194158, -0.0004163972634503787, 0.00024331263405118046, -0.00014773967346396843,
+  8.301743329811526e-05, -3.0400556406355272e-05,
+};
+
+// the polynomial parts of the anti-derivatives past kNear, in powers of |x|, constant term first:
+// each is the integral of the one before, plus the constant that makes it 0 at 0
+constexpr double kFar[5][5] = {
+  {1.},
+  {-kLn2, 1.},
+  {kPiSquared / 24., -kLn2, 1. / 2.},
+  {-3. * kZeta3 / 16., kPiSquared / 24., -kLn2 / 2., 1. / 6.},
+  {7. * kPiFourth / 5760., -3. * kZeta3 / 16., kPiSquared / 48., -kLn2 / 6., 1. / 24.},
+};
+
+// the K-th anti-derivative near 0 is x^(K + 1) times a polynomial in x^2,
+// with these coefficients: those of log cosh, differentiated or integrated term by term
+struct NearCoefficients {
+  double c[kLogCoshDegree + 1];
+};
+
+template <int K>
+constexpr NearCoefficients nearCoefficients() {
+  NearCoefficients out{};
+  for (int j = 0; j <= kLogCoshDegree; ++j) {
+    // log cosh x has the term kLogCosh[j] x^(2j + 2)
+    double scale = K == 0 ? 2. * j + 2. : 1.;
+    for (int m = 1; m < K; ++m) {
+      scale /= 2. * j + 2. + m;
+    }
+    out.c[j] = kLogCosh[j] * scale;
+  }
+  return out;
+}
+
+// e^y for y <= 0, by y = n log 2 + r, |r| <= log(2) / 2.
+// 2^n is assembled in the exponent bits from n, which is read out of the bits of the rounded y / log 2.
+// below -80, e^y is taken to be e^-80, which is already too small to matter to any of the above.
+template <class Real>
+inline Real expNonPositive(Real y) {
+  y = y < static_cast<Real>(-80.) ? static_cast<Real>(-80.) : y;
+  if constexpr (std::is_same_v<Real, float>) {
+    // adding 1.5 * 2^23 rounds to an integer, which lands in the low bits of the mantissa
+    constexpr float kShift = 12582912.f;
+    const float shifted = y * 1.44269504f + kShift;
+    const float n = shifted - kShift;
+    const float r = (y - n * 0.693145752f) - n * 1.42860677e-06f;
+    uint32_t bits;
+    std::memcpy(&bits, &shifted, sizeof(bits));
+    const uint32_t scaleBits = (bits + 127u) << 23;
+    float scale;
+    std::memcpy(&scale, &scaleBits, sizeof(scale));
+    return horner<11>(kExp, r) * scale;
+  } else {
+    // adding 1.5 * 2^52 rounds to an integer, which lands in the low bits of the mantissa
+    constexpr double kShift = 6755399441055744.;
+    const double shifted = y * 1.4426950408889634 + kShift;
+    const double n = shifted - kShift;
+    // log 2 in two parts, the first short enough that n times it is exact
+    const double r = (y - n * 6.93147180369123816490e-01) - n * 1.90821492927058770002e-10;
+    uint64_t bits;
+    std::memcpy(&bits, &shifted, sizeof(bits));
+    const uint64_t scaleBits = (bits + 1023u) << 52;
+    double scale;
+    std::memcpy(&scale, &scaleBits, sizeof(scale));
+    return horner<11>(kExp, r) * scale;
+  }
+}
+
+// Li_K(-u) for 0 <= u <= kFarU; Li0(-u) is -u / (1 + u)
+template <int K, class Real>
+inline Real polylogOfNegative(Real u) {
+  if constexpr (K == 0) {
+    return -u / (static_cast<Real>(1.) + u);
+  } else if constexpr (K == 1) {
+    return u * horner<12>(kLi1, u);
+  } else if constexpr (K == 2) {
+    return u * horner<11>(kLi2, u);
+  } else if constexpr (K == 3) {
+    return u * horner<11>(kLi3, u);
+  } else {
+    return u * horner<10>(kLi4, u);
+  }
+}
+
+} // namespace polylog
+
+// the K-th anti-derivative of tanh, each 0 at 0 (the 0th being tanh itself).
+// both the polynomial near 0 and the polylogarithms are evaluated and the one for in kept.
+// the even anti-derivatives are odd functions and the odd ones even, so both work from |in|.
+template <int K, class Real>
+inline Real tanhAntiderivative(Real in) {
+  using namespace polylog;
+  static_assert(K >= 0 && K <= 4, "tanh has anti-derivatives up to the fourth here");
+  constexpr NearCoefficients kNearK = nearCoefficients<K>();
+  const Real x = std::abs(in);
+  const Real s = x * x;
+
+  Real power = x;
+  for (int k = 0; k < K; ++k) {
+    power *= x;
+  }
+  const Real near = power * horner<kLogCoshDegree>(kNearK.c, s);
+
+  // 2 (-1/2)^K Li_K(-u), the term each integration halves and flips
+  constexpr double kScale = K % 2 == 0 ? 2. / (1 << K) : -2. / (1 << K);
+  const Real u = expNonPositive(static_cast<Real>(-2.) * x);
+  const Real far = horner<K>(kFar[K], x) + static_cast<Real>(kScale) * polylogOfNegative<K>(u);
+
+  const Real out = x <= static_cast<Real>(kNear) ? near : far;
+  if constexpr (K % 2 == 0) {
+    return in < static_cast<Real>(0.) ? -out : out;
+  } else {
+    return out;
+  }
+}
+
+} // namespace DADAA_TARGET
+} // namespace DADAA
@@ -0,0 +1,89 @@
+// Polynomial.hpp
+// Rylee Alanza Lyman (ryleealanza@gmail.com)
+//
+// curves made of polynomial pieces, written down once as arrays of coefficients.
+// their anti-derivatives are integrated at compile time, with the constants that make them continuous,
+// so that a shaper is defined by its waveshaper alone (see Shapers.hpp).
+
+#pragma once
+
+#include "Target.hpp"
+
+namespace DADAA {
+inline namespace DADAA_TARGET {
+
+// c[0] + c[1] t + ... + c[Degree] t^Degree, by Horner's scheme
+template <int Degree, class Real>
+constexpr Real horner(const double* c, Real t) {
+  Real out = static_cast<Real>(c[Degree]);
+  for (int j = Degree - 1; j >= 0; --j) {
+    out = out * t + static_cast<Real>(c[j]);
+  }
+  return out;
+}
+
+// Segments polynomial pieces of degree Degree.
+// piece s covers [breaks[s - 1], breaks[s]), the first and last reaching out to minus and plus infinity,
+// and is written in powers of t = in - origins[s], constant term first.
+template <int Segments, int Degree>
+struct Piecewise {
+  static constexpr int kSegments = Segments;
+  static constexpr int kDegree = Degree;
+
+  double breaks[Segments > 1 ? Segments - 1 : 1];
+  double origins[Segments];
+  double coefficients[Segments][Degree + 1];
+
+  // the piece that in falls in
+  template <class Real>
+  constexpr int piece(Real in) const {
+    int s = 0;
+    for (int b = 0; b < Segments - 1; ++b) {
+      s += in >= static_cast<Real>(breaks[b]) ? 1 : 0;
+    }
+    return s;
+  }
+
+  // the curve at in.
+  // every piece is evaluated and the one in falls in kept, so that loops over this vectorize.
+  template <class Real>
+  constexpr Real operator()(Real in) const {
+    Real out = horner<Degree>(coefficients[0], in - static_cast<Real>(origins[0]));
+    for (int s = 1; s < Segments; ++s) {
+      const Real value = horner<Degree>(coefficients[s], in - static_cast<Real>(origins[s]));
+      out = in >= static_cast<Real>(breaks[s - 1]) ? value : out;
+    }
+    return out;
+  }
+
+  // the anti-derivative that is 0 at the origin of piece anchor,
+  // with the constants of the other pieces chosen so that it is continuous
+  constexpr Piecewise<Segments, Degree + 1> integral(int anchor) const {
+    Piecewise<Segments, Degree + 1> out{};
+    for (int b = 0; b < Segments - 1; ++b) {
+      out.breaks[b] = breaks[b];
+    }
+    for (int s = 0; s < Segments; ++s) {
+      out.origins[s] = origins[s];
+      out.coefficients[s][0] = 0.;
+      for (int j = 1; j <= Degree + 1; ++j) {
+        out.coefficients[s][j] = coefficients[s][j - 1] / j;
+      }
+    }
+    // outward from the anchor, each piece meets the one before it at their break
+    for (int s = anchor + 1; s < Segments; ++s) {
+      const double at = breaks[s - 1];
+      out.coefficients[s][0] = horner<Degree + 1>(out.coefficients[s - 1], at - origins[s - 1])
+                               - horner<Degree + 1>(out.coefficients[s], at - origins[s]);
+    }
+    for (int s = anchor - 1; s >= 0; --s) {
+      const double at = breaks[s];
+      out.coefficients[s][0] = horner<Degree + 1>(out.coefficients[s + 1], at - origins[s + 1])
+                               - horner<Degree + 1>(out.coefficients[s], at - origins[s]);
+    }
+    return out;
+  }
+};
+
+} // namespace DADAA_TARGET
+} // namespace DADAA
@@ -0,0 +1,189 @@
+// PolynomialShaper.hpp
+// Rylee Alanza Lyman (ryleealanza@gmail.com)
+//
+// a waveshaper made of polynomial pieces, read from a table at run time.
+// its anti-derivatives are worked out once, when it is built,
+// so that it runs through the same kernels as the shapers in Shapers.hpp.
+
+#pragma once
+
+#include "Target.hpp"
+
+#include <cmath>
+
+namespace DADAA {
+inline namespace DADAA_TARGET {
+
+// the table is a flat array of floats:
+//   segments, degree,
+//   the segments - 1 breakpoints between the pieces, strictly increasing,
+//   then for each piece its degree + 1 coefficients, constant term first.
+// the first and last pieces extend to minus and plus infinity.
+// the pieces need not meet at the breakpoints; the anti-derivatives are made continuous regardless.
+class PolynomialShaper {
+public:
+  static constexpr int kMaxSegments = 256;
+  static constexpr int kMaxDegree = 5;
+
+  double eps = 0.001;
+
+  // nullptr if table, of size floats, is well formed, and otherwise what is wrong with it
+  static const char* check(const float* table, int size) {
+    if (size < 2) {
+      return "the table is too short";
+    }
+    const float segments = table[0];
+    const float degree = table[1];
+    if (!(segments >= 1.f && segments <= kMaxSegments) || segments != std::floor(segments)) {
+      return "the number of segments must be a whole number from 1 to 256";
+    }
+    if (!(degree >= 0.f && degree <= kMaxDegree) || degree != std::floor(degree)) {
+      return "the degree must be a whole number from 0 to 5";
+    }
+    const int s = static_cast<int>(segments);
+    const int d = static_cast<int>(degree);
+    if (size < 2 + (s - 1) + s * (d + 1)) {
+      return "the table is too short for its segments and degree";
+    }
+    for (int i = 2; i < 2 + (s - 1) + s * (d + 1); ++i) {
+      if (!std::isfinite(table[i])) {
+        return "the table holds a value that is not finite";
+      }
+    }
+    for (int i = 3; i < 2 + (s - 1); ++i) {
+      if (!(table[i - 1] < table[i])) {
+        return "the breakpoints must be strictly increasing";
+      }
+    }
+    return nullptr;
+  }
+
+  // the number of doubles of storage needed for a checked table
+  static int storageSize(const float* table) {
+    const int segments = static_cast<int>(table[0]);
+    return searchSize(segments) + segments * kStride;
+  }
+
+  // the shaper that is 0 everywhere, until one is built from a table
+  PolynomialShaper() : mLeft(kZero), mPieces(kZero + 1) {}
+
+  // table must have passed check.
+  // storage must hold storageSize(table) doubles and outlive this object.
+  PolynomialShaper(double* storage, const float* table) {
+    const int segments = static_cast<int>(table[0]);
+    const int degree = static_cast<int>(table[1]);
+    const float* breaks = table + 2;
+    const float* coefficients = breaks + (segments - 1);
+
+    // mLeft[i] is the left end of piece i, padded with infinities to a power of two for the search
+    mSearch = searchSize(segments);
+    double* left = storage;
+    double* pieces = storage + mSearch;
+    for (int i = 0; i < mSearch; ++i) {
+      left[i] = i == 0 ? -INFINITY : i < segments ? static_cast<double>(breaks[i - 1]) : INFINITY;
+    }
+    mLeft = left;
+    mPieces = pieces;
+
+    // each piece is kept in powers of its distance from an anchor:
+    // its left end, or for the first piece its right end
+    for (int i = 0; i < segments; ++i) {
+      double* piece = pieces + i * kStride;
+      const double anchor = i > 0 ? mLeft[i] : segments > 1 ? mLeft[1] : 0.;
+      piece[0] = anchor;
+      double* shaper = piece + 1;
+      for (int k = 0; k < kMaxDegree + 1; ++k) {
+        shaper[k] = 0.;
+      }
+      // Taylor shift: x^j = sum over k of binom(j, k) anchor^(j - k) (x - anchor)^k
+      for (int j = 0; j <= degree; ++j) {
+        const double a = coefficients[i * (degree + 1) + j];
+        double binomial = 1.;
+        for (int k = j; k >= 0; --k) {
+          shaper[k] += a * binomial * std::pow(anchor, j - k);
+          binomial = binomial * k / (j - k + 1);
+        }
+      }
+    }
+
+    // integrate level by level, choosing each piece's constant so that it meets the last piece
+    for (int level = 1; level <= 4; ++level) {
+      for (int i = 0; i < segments; ++i) {
+        const double* below = coefficientsAt(i, level - 1);
+        double* out = pieces + i * kStride + offset(level);
+        const int count = kMaxDegree + level;
+        for (int j = 1; j <= count; ++j) {
+          out[j] = below[j - 1] / j;
+        }
+        if (i == 0) {
+          out[0] = 0.;
+        } else {
+          const double* last = coefficientsAt(i - 1, level);
+          const double t = mLeft[i] - mPieces[(i - 1) * kStride];
+          out[0] = horner(last, count, t);
+        }
+      }
+    }
+  }
+
+  double waveshape0(double in) const { return evaluate<0>(in); }
+  double waveshape1(double in) const { return evaluate<1>(in); }
+  double waveshape2(double in) const { return evaluate<2>(in); }
+  double waveshape3(double in) const { return evaluate<3>(in); }
+  double waveshape4(double in) const { return evaluate<4>(in); }
+
+private:
+  // anchor, then the coefficients of the shaper and its anti-derivatives,
+  // kMaxDegree + 1 + level of them at each level
+  static constexpr int offset(int level) { return 1 + level * (kMaxDegree + 1) + level * (level - 1) / 2; }
+  // that is offset(5)
+  static constexpr int kStride = 1 + 5 * (kMaxDegree + 1) + 10;
+
+  static int searchSize(int segments) {
+    int size = 1;
+    while (size < segments) {
+      size *= 2;
+    }
+    return size;
+  }
+
+  // coefficients c[0], ..., c[degree] at t
+  static double horner(const double* c, int degree, double t) {
+    double out = c[degree];
+    for (int j = degree - 1; j >= 0; --j) {
+      out = out * t + c[j];
+    }
+    return out;
+  }
+
+  const double* coefficientsAt(int segment, int level) const { return mPieces + segment * kStride + offset(level); }
+
+  // the last piece whose left end is at most in, without branches
+  int segment(double in) const {
+    int segment = 0;
+    for (int step = mSearch / 2; step > 0; step /= 2) {
+      segment += in >= mLeft[segment + step] ? step : 0;
+    }
+    return segment;
+  }
+
+  template <int Level>
+  double evaluate(double in) const {
+    const double* piece = mPieces + segment(in) * kStride;
+    const double* c = piece + offset(Level);
+    // the degree is known here, so this unrolls
+    return horner(c, kMaxDegree + Level, in - piece[0]);
+  }
+
+  // the left end and the piece of the zero shaper
+  static constexpr double kZero[1 + kStride] = {-INFINITY};
+
+  int mSearch = 1;
+  // left ends of the pieces, padded
+  const double* mLeft;
+  // kStride doubles per piece
+  const double* mPieces;
+};
+
+} // namespace DADAA_TARGET
+} // namespace DADAA
@@ -0,0 +1,118 @@
+// Shapers.hpp
+// Rylee Alanza Lyman (ryleealanza@gmail.com)
+//
+// waveshapers and their anti-derivatives, for use with the kernels in Kernels.hpp
+
+#pragma once
+
+#include "Polylog.hpp"
+#include "Polynomial.hpp"
+#include "Target.hpp"
+
+namespace DADAA {
+inline namespace DADAA_TARGET {
+
+// piecewise polynomial approximation to tanh
+struct TanhShaper {
+  static constexpr double eps = 0.001;
+  static constexpr float epsFloat = 0.01f;
+
+  // the waveshaper: x - x^3/3 near 0, cubics out to +-3, then flat
+  static constexpr Piecewise<5, 3> kCurve = {
+    {-3., -0.5, 0.5, 3.},
+    {-3., -0.5, 0., 0.5, 3.},
+    {
+      {-1.},
+      {-11. / 24., 3. / 4., 17. / 50., 19. / 375.},
+      {0., 1., 0., -1. / 3.},
+      {11. / 24., 3. / 4., -17. / 50., 19. / 375.},
+      {1.},
+    },
+  };
+  // its anti-derivatives, each 0 at 0
+  static constexpr Piecewise<5, 4> kW1 = kCurve.integral(2);
+  static constexpr Piecewise<5, 5> kW2 = kW1.integral(2);
+  static constexpr Piecewise<5, 6> kW3 = kW2.integral(2);
+  static constexpr Piecewise<5, 7> kW4 = kW3.integral(2);
+
+  // final anti-derivative
+  template <class Real>
+  static inline Real waveshape4(Real in) { return kW4(in); }
+  // third anti-derivative
+  template <class Real>
+  static inline Real waveshape3(Real in) { return kW3(in); }
+  // second anti-derivative
+  template <class Real>
+  static inline Real waveshape2(Real in) { return kW2(in); }
+  // first anti-derivative
+  template <class Real>
+  static inline Real waveshape1(Real in) { return kW1(in); }
+  // trivial waveshaper
+  template <class Real>
+  static inline Real waveshape0(Real in) { return kCurve(in); }
+};
+
+// tanh itself, with its anti-derivatives in closed form (see Polylog.hpp).
+// several times the cost of TanhShaper, which only follows tanh to within about 0.025.
+// with no flat pieces to take over, the fourth differences of loud inputs divide anti-derivatives in the thousands,
+// hence the wider epsilon.
+struct ExactTanhShaper {
+  static constexpr double eps = 0.01;
+  static constexpr float epsFloat = 0.01f;
+
+  // final anti-derivative
+  template <class Real>
+  static inline Real waveshape4(Real in) { return tanhAntiderivative<4>(in); }
+  // third anti-derivative
+  template <class Real>
+  static inline Real waveshape3(Real in) { return tanhAntiderivative<3>(in); }
+  // second anti-derivative
+  template <class Real>
+  static inline Real waveshape2(Real in) { return tanhAntiderivative<2>(in); }
+  // first anti-derivative, log cosh
+  template <class Real>
+  static inline Real waveshape1(Real in) { return tanhAntiderivative<1>(in); }
+  // trivial waveshaper
+  template <class Real>
+  static inline Real waveshape0(Real in) { return tanhAntiderivative<0>(in); }
+};
+
+// hard clipping to [-1, 1]
+struct ClipShaper {
+  static constexpr double eps = 0.001;
+  static constexpr float epsFloat = 0.01f;
+
+  static constexpr Piecewise<3, 1> kCurve = {
+    {-1., 1.},
+    {-1., 0., 1.},
+    {
+      {-1.},
+      {0., 1.},
+      {1.},
+    },
+  };
+  // its anti-derivatives, each 0 at -1
+  static constexpr Piecewise<3, 2> kW1 = kCurve.integral(0);
+  static constexpr Piecewise<3, 3> kW2 = kW1.integral(0);
+  static constexpr Piecewise<3, 4> kW3 = kW2.integral(0);
+  static constexpr Piecewise<3, 5> kW4 = kW3.integral(0);
+
+  // final anti-derivative
+  template <class Real>
+  static inline Real waveshape4(Real in) { return kW4(in); }
+  // third anti-derivative
+  template <class Real>
+  static inline Real waveshape3(Real in) { return kW3(in); }
+  // second anti-derivative
+  template <class Real>
+  static inline Real waveshape2(Real in) { return kW2(in); }
+  // first anti-derivative
+  template <class Real>
+  static inline Real waveshape1(Real in) { return kW1(in); }
+  // trivial waveshaper
+  template <class Real>
+  static inline Real waveshape0(Real in) { return kCurve(in); }
+};
+
+} // namespace DADAA_TARGET
+} // namespace DADAA
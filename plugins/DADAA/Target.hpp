@@ -0,0 +1,27 @@
+// Target.hpp
+// Rylee Alanza Lyman (ryleealanza@gmail.com)
+//
+// the instruction set the kernels are built for.
+// the plugin builds its units once per instruction set and registers the best one the CPU runs (see DADAA.cpp).
+// each build puts everything in an inline namespace named for its target, so that the linker,
+// which keeps one copy of each inline function and template instance, never swaps one build's copy for another's.
+
+#pragma once
+
+// the standard headers the kernels and units use, so that a build for a wider instruction set
+// can have them all in before it switches targets: like SuperCollider's headers,
+// their inline functions are shared by every build, and must be built for the baseline
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#ifndef DADAA_TARGET
+#define DADAA_TARGET generic
+#endif
+
+// the wider builds are for x86-64, with GCC or Clang, which can switch targets part way through a file
+#if defined(__x86_64__) && defined(__GNUC__)
+#define DADAA_DISPATCH 1
+#endif
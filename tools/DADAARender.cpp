@@ -0,0 +1,469 @@
+// DADAARender.cpp
+// Rylee Alanza Lyman (ryleealanza@gmail.com)
+//
+// offline rendering of files through the DADAA shapers, without a server.
+// each channel of each file is split into chunks that are rendered in parallel,
+// and the output is the same, bit for bit, as rendering it from start to end in blocks of 64.
+//
+// a Distortion's state is its window of the last four inputs and the differences it holds over them.
+// a block of 64 that moves rebuilds all of them from its own inputs, whatever they were before,
+// but a settled block (see Distortion::run) leaves them as they were.
+// so each chunk starts a fresh Distortion one block before the last block ahead of it that moved:
+// that block fills in the window, the one that moved takes the same branches as it would in a serial run,
+// and everything from there on is computed as in a serial run.
+// usually that is the one block just before the chunk, i.e. its five-sample history padded out to a block.
+//
+// usage: DADAARender [options] <input> <output> [<input> <output> ...]
+// inputs are WAV files (16, 24 or 32-bit integer, or 32 or 64-bit float), or raw 32-bit float with --raw;
+// outputs are 32-bit float WAV, or raw 32-bit float with --raw. everything is taken to be little-endian.
+
+#include "Distortion.hpp"
+#include "Shapers.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define DADAA_MMAP 1
+#endif
+
+namespace {
+
+constexpr int kBlockSize = 64;
+
+struct Options {
+  std::string shaper = "tanh";
+  float gain = 1.f;
+  int order = 4;
+  unsigned threads = 0;
+  size_t chunk = 1 << 16;
+  bool raw = false;
+  int channels = 1;
+};
+
+// a whole file, mapped into memory where the platform allows it, otherwise read in
+class InputFile {
+public:
+  InputFile() = default;
+  InputFile(const InputFile&) = delete;
+  InputFile& operator=(const InputFile&) = delete;
+
+  ~InputFile() {
+#ifdef DADAA_MMAP
+    if (mMapped != nullptr) {
+      munmap(mMapped, mSize);
+    }
+#endif
+  }
+
+  // an error message, or nullptr
+  const char* open(const char* path) {
+#ifdef DADAA_MMAP
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+      return "can't open it";
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+      void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapped != MAP_FAILED) {
+        mMapped = mapped;
+        mSize = static_cast<size_t>(info.st_size);
+        mData = static_cast<const unsigned char*>(mapped);
+        // each chunk reads its part of the file front to back
+        madvise(mapped, mSize, MADV_SEQUENTIAL);
+        ::close(fd);
+        return nullptr;
+      }
+    }
+    ::close(fd);
+#endif
+    // not mappable, e.g. a pipe: read it all in
+    FILE* file = std::fopen(path, "rb");
+    if (file == nullptr) {
+      return "can't open it";
+    }
+    unsigned char buffer[1 << 16];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof buffer, file)) > 0) {
+      mCopy.insert(mCopy.end(), buffer, buffer + read);
+    }
+    const bool failed = std::ferror(file) != 0;
+    std::fclose(file);
+    if (failed) {
+      return "can't read it";
+    }
+    mData = mCopy.data();
+    mSize = mCopy.size();
+    return nullptr;
+  }
+
+  const unsigned char* data() const { return mData; }
+  size_t size() const { return mSize; }
+
+private:
+  const unsigned char* mData = nullptr;
+  size_t mSize = 0;
+  void* mMapped = nullptr;
+  std::vector<unsigned char> mCopy;
+};
+
+enum class Encoding { kInt16, kInt24, kInt32, kFloat32, kFloat64 };
+
+// interleaved samples in memory, as read from a file
+struct Audio {
+  const unsigned char* samples = nullptr;
+  Encoding encoding = Encoding::kFloat32;
+  int channels = 1;
+  size_t frames = 0;
+  double sampleRate = 48000.;
+
+  int bytesPerSample() const {
+    switch (encoding) {
+    case Encoding::kInt16:
+      return 2;
+    case Encoding::kInt24:
+      return 3;
+    case Encoding::kFloat64:
+      return 8;
+    default:
+      return 4;
+    }
+  }
+
+  // count samples of one channel from the given frame, as floats
+  void read(int channel, size_t frame, int count, float* out) const {
+    const int width = bytesPerSample();
+    const size_t stride = static_cast<size_t>(width) * channels;
+    const unsigned char* at = samples + frame * stride + static_cast<size_t>(channel) * width;
+    for (int i = 0; i < count; ++i, at += stride) {
+      switch (encoding) {
+      case Encoding::kInt16:
+        out[i] = static_cast<float>(static_cast<int16_t>(at[0] | at[1] << 8)) / 32768.f;
+        break;
+      case Encoding::kInt24: {
+        // the three bytes at the top of an int32, shifted back down with their sign
+        const uint32_t bits = static_cast<uint32_t>(at[0]) << 8 | static_cast<uint32_t>(at[1]) << 16 |
+                              static_cast<uint32_t>(at[2]) << 24;
+        out[i] = static_cast<float>(static_cast<int32_t>(bits) >> 8) / 8388608.f;
+        break;
+      }
+      case Encoding::kInt32: {
+        int32_t value;
+        std::memcpy(&value, at, 4);
+        out[i] = static_cast<float>(value) / 2147483648.f;
+        break;
+      }
+      case Encoding::kFloat32:
+        std::memcpy(out + i, at, 4);
+        break;
+      case Encoding::kFloat64: {
+        double value;
+        std::memcpy(&value, at, 8);
+        out[i] = static_cast<float>(value);
+        break;
+      }
+      }
+    }
+  }
+};
+
+uint32_t le32(const unsigned char* at) { return at[0] | at[1] << 8 | at[2] << 16 | static_cast<uint32_t>(at[3]) << 24; }
+uint16_t le16(const unsigned char* at) { return static_cast<uint16_t>(at[0] | at[1] << 8); }
+
+// the samples of a WAV file; an error message, or nullptr
+const char* parseWav(const unsigned char* data, size_t size, Audio& audio) {
+  if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0) {
+    return "not a WAV file";
+  }
+  bool haveFormat = false;
+  for (size_t at = 12; at + 8 <= size;) {
+    const uint32_t length = le32(data + at + 4);
+    const unsigned char* body = data + at + 8;
+    const size_t available = std::min<size_t>(length, size - at - 8);
+    if (std::memcmp(data + at, "fmt ", 4) == 0 && available >= 16) {
+      uint16_t format = le16(body);
+      const int channels = le16(body + 2);
+      const int bits = le16(body + 14);
+      if (format == 0xFFFE && available >= 26) {
+        // WAVE_FORMAT_EXTENSIBLE: the format is the start of the subformat GUID
+        format = le16(body + 24);
+      }
+      if (format == 1 && bits == 16) {
+        audio.encoding = Encoding::kInt16;
+      } else if (format == 1 && bits == 24) {
+        audio.encoding = Encoding::kInt24;
+      } else if (format == 1 && bits == 32) {
+        audio.encoding = Encoding::kInt32;
+      } else if (format == 3 && bits == 32) {
+        audio.encoding = Encoding::kFloat32;
+      } else if (format == 3 && bits == 64) {
+        audio.encoding = Encoding::kFloat64;
+      } else {
+        return "unsupported sample format";
+      }
+      if (channels < 1) {
+        return "no channels";
+      }
+      audio.channels = channels;
+      audio.sampleRate = le32(body + 4);
+      haveFormat = true;
+    } else if (std::memcmp(data + at, "data", 4) == 0) {
+      if (!haveFormat) {
+        return "data before the format";
+      }
+      audio.samples = body;
+      audio.frames = available / (static_cast<size_t>(audio.bytesPerSample()) * audio.channels);
+      return nullptr;
+    }
+    // chunks are padded to an even length
+    at += 8 + static_cast<size_t>(length) + (length & 1);
+  }
+  return "no data";
+}
+
+// a 32-bit float WAV file, or raw floats
+bool writeOutput(const char* path, const std::vector<float>& samples, int channels, double sampleRate, bool raw) {
+  FILE* file = std::fopen(path, "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  bool ok = true;
+  if (!raw) {
+    const uint32_t dataBytes = static_cast<uint32_t>(samples.size() * sizeof(float));
+    const uint32_t rate = static_cast<uint32_t>(sampleRate);
+    const uint16_t blockAlign = static_cast<uint16_t>(channels * sizeof(float));
+    unsigned char header[44];
+    auto put32 = [&header](int at, uint32_t value) {
+      for (int i = 0; i < 4; ++i) {
+        header[at + i] = static_cast<unsigned char>(value >> (8 * i));
+      }
+    };
+    auto put16 = [&header](int at, uint16_t value) {
+      header[at] = static_cast<unsigned char>(value);
+      header[at + 1] = static_cast<unsigned char>(value >> 8);
+    };
+    std::memcpy(header, "RIFF", 4);
+    put32(4, 36 + dataBytes);
+    std::memcpy(header + 8, "WAVEfmt ", 8);
+    put32(16, 16);
+    put16(20, 3);
+    put16(22, static_cast<uint16_t>(channels));
+    put32(24, rate);
+    put32(28, rate * blockAlign);
+    put16(32, blockAlign);
+    put16(34, 32);
+    std::memcpy(header + 36, "data", 4);
+    put32(40, dataBytes);
+    ok = std::fwrite(header, 1, sizeof header, file) == sizeof header;
+  }
+  ok = ok && std::fwrite(samples.data(), sizeof(float), samples.size(), file) == samples.size();
+  return std::fclose(file) == 0 && ok;
+}
+
+// the input as Distortion's window holds it
+inline double scaledAt(float raw, float gain) {
+  return DADAA::flushDenormal(static_cast<double>(raw * static_cast<double>(gain)));
+}
+
+// whether a serial run would find block `block` settled: it and the four inputs before it all the same
+bool settledBlock(const Audio& audio, int channel, size_t block, float gain) {
+  const size_t start = block * kBlockSize;
+  if (start < 4) {
+    return false;
+  }
+  const size_t end = std::min(start + kBlockSize, audio.frames);
+  float raw[kBlockSize + 4];
+  const int count = static_cast<int>(end - start + 4);
+  audio.read(channel, start - 4, count, raw);
+  const double x = scaledAt(raw[0], gain);
+  for (int i = 1; i < count; ++i) {
+    if (scaledAt(raw[i], gain) != x) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// one channel of one file, from frame `begin` to `end`, into the interleaved output.
+// begin is a whole number of blocks into the file.
+template <class Shaper, int Order>
+void renderChunk(const Audio& audio, int channel, size_t begin, size_t end, float gain, float* out) {
+  size_t block = begin / kBlockSize;
+  while (block > 0 && settledBlock(audio, channel, block - 1, gain)) {
+    --block;
+  }
+  // the block before the last one that moved, to fill in its window
+  size_t frame = block > 1 ? (block - 2) * kBlockSize : 0;
+  DADAA::Distortion<Shaper> distortion(gain);
+  float input[kBlockSize];
+  float wet[kBlockSize];
+  for (; frame < end; frame += kBlockSize) {
+    const int count = static_cast<int>(std::min<size_t>(kBlockSize, audio.frames - frame));
+    audio.read(channel, frame, count, input);
+    distortion.template process<Order>(input, gain, wet, nullptr, count);
+    if (frame >= begin) {
+      for (int i = 0; i < count; ++i) {
+        out[(frame + i) * audio.channels + channel] = wet[i];
+      }
+    }
+  }
+}
+
+using RenderFunction = void (*)(const Audio&, int, size_t, size_t, float, float*);
+
+template <class Shaper>
+RenderFunction renderFunctionForOrder(int order) {
+  switch (order) {
+  case 0:
+    return renderChunk<Shaper, 0>;
+  case 1:
+    return renderChunk<Shaper, 1>;
+  case 2:
+    return renderChunk<Shaper, 2>;
+  case 3:
+    return renderChunk<Shaper, 3>;
+  default:
+    return renderChunk<Shaper, 4>;
+  }
+}
+
+RenderFunction renderFunctionFor(const std::string& shaper, int order) {
+  if (shaper == "clip") {
+    return renderFunctionForOrder<DADAA::ClipShaper>(order);
+  }
+  if (shaper == "tanh") {
+    return renderFunctionForOrder<DADAA::TanhShaper>(order);
+  }
+  if (shaper == "exact-tanh") {
+    return renderFunctionForOrder<DADAA::ExactTanhShaper>(order);
+  }
+  return nullptr;
+}
+
+struct Task {
+  const Audio* audio;
+  int channel;
+  size_t begin;
+  size_t end;
+  float* out;
+};
+
+void usage(const char* name) {
+  std::fprintf(stderr,
+               "usage: %s [options] <input> <output> [<input> <output> ...]\n"
+               "  --shaper clip|tanh|exact-tanh  the shaper of CADAA, TADAA or ETADAA (default tanh)\n"
+               "  --gain G                       scales the input before it is shaped (default 1)\n"
+               "  --order N                      the order of anti-aliasing, 0 to 4 (default 4)\n"
+               "  --threads N                    worker threads (default: one per core)\n"
+               "  --chunk FRAMES                 frames per parallel chunk (default 65536)\n"
+               "  --raw                          raw 32-bit float files in and out, rather than WAV\n"
+               "  --channels N                   channels of raw input (default 1)\n",
+               name);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  std::vector<const char*> paths;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if (arg == "--shaper" && hasValue) {
+      options.shaper = argv[++i];
+    } else if (arg == "--gain" && hasValue) {
+      options.gain = static_cast<float>(std::atof(argv[++i]));
+    } else if (arg == "--order" && hasValue) {
+      options.order = std::atoi(argv[++i]);
+    } else if (arg == "--threads" && hasValue) {
+      options.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+    } else if (arg == "--chunk" && hasValue) {
+      options.chunk = static_cast<size_t>(std::atoll(argv[++i]));
+    } else if (arg == "--raw") {
+      options.raw = true;
+    } else if (arg == "--channels" && hasValue) {
+      options.channels = std::atoi(argv[++i]);
+    } else if (arg.size() > 1 && arg[0] == '-') {
+      usage(argv[0]);
+      return 1;
+    } else {
+      paths.push_back(argv[i]);
+    }
+  }
+  const RenderFunction render = renderFunctionFor(options.shaper, options.order);
+  if (paths.empty() || paths.size() % 2 != 0 || render == nullptr || options.order < 0 || options.order > 4 ||
+      options.channels < 1 || options.chunk == 0) {
+    usage(argv[0]);
+    return 1;
+  }
+  // chunks start on whole blocks, as a serial run's blocks do
+  options.chunk = (options.chunk + kBlockSize - 1) / kBlockSize * kBlockSize;
+
+  const size_t files = paths.size() / 2;
+  std::vector<InputFile> inputs(files);
+  std::vector<Audio> audio(files);
+  std::vector<std::vector<float>> outputs(files);
+  std::vector<Task> tasks;
+  for (size_t file = 0; file < files; ++file) {
+    const char* path = paths[2 * file];
+    const char* error = inputs[file].open(path);
+    if (error == nullptr && options.raw) {
+      audio[file].samples = inputs[file].data();
+      audio[file].channels = options.channels;
+      audio[file].frames = inputs[file].size() / (sizeof(float) * options.channels);
+    } else if (error == nullptr) {
+      error = parseWav(inputs[file].data(), inputs[file].size(), audio[file]);
+    }
+    if (error != nullptr) {
+      std::fprintf(stderr, "DADAARender: %s: %s\n", path, error);
+      return 1;
+    }
+    outputs[file].assign(audio[file].frames * audio[file].channels, 0.f);
+    for (int channel = 0; channel < audio[file].channels; ++channel) {
+      for (size_t begin = 0; begin < audio[file].frames; begin += options.chunk) {
+        const size_t end = std::min(begin + options.chunk, audio[file].frames);
+        tasks.push_back({&audio[file], channel, begin, end, outputs[file].data()});
+      }
+    }
+  }
+
+  // every chunk of every channel of every file goes in one queue
+  std::atomic<size_t> next(0);
+  auto work = [&]() {
+    for (size_t task = next++; task < tasks.size(); task = next++) {
+      const Task& t = tasks[task];
+      render(*t.audio, t.channel, t.begin, t.end, options.gain, t.out);
+    }
+  };
+  unsigned threads = options.threads != 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+  threads = static_cast<unsigned>(std::min<size_t>(threads, tasks.size()));
+  std::vector<std::thread> workers;
+  for (unsigned i = 1; i < threads; ++i) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  for (size_t file = 0; file < files; ++file) {
+    const char* path = paths[2 * file + 1];
+    if (!writeOutput(path, outputs[file], audio[file].channels, audio[file].sampleRate, options.raw)) {
+      std::fprintf(stderr, "DADAARender: %s: can't write it\n", path);
+      return 1;
+    }
+  }
+  return 0;
+}